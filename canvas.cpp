@@ -21,9 +21,14 @@
 ***************************************************************************/
 #include "canvas.h"
 #include <QGraphicsSceneDragDropEvent>
+#include <QKeyEvent>
 #include <QMimeData>
 #include <QUrl>
 #include <QDebug>
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+#include <QGraphicsView>
 #include <cmath>
 
 #include "undo/deletefieldcommand.h"
@@ -32,13 +37,23 @@
 #include "undo/setbackgroundimage.h"
 
 #include "tablecanvasfield.h"
+#include "tiledbackgrounditem.h"
+#include "imagemodel.h"
+#include "imagestore.h"
 
 //#include "charactersheetbutton.h"
 
+#define SNAP_DISTANCE 6
+#define SNAP_RANGE 256
+
 Canvas::Canvas(QObject *parent)
-    : QGraphicsScene(parent),m_bg(nullptr),m_currentItem(nullptr),m_pix(nullptr),m_model(nullptr),m_undoStack(nullptr)
+    : QGraphicsScene(parent),m_bg(nullptr),m_currentItem(nullptr),m_model(nullptr),m_undoStack(nullptr)
 {
     setSceneRect(QRect(0,0,800,600));
+    m_selectionTimer.setSingleShot(true);
+    m_selectionTimer.setInterval(0);
+    connect(this,SIGNAL(selectionChanged()),&m_selectionTimer,SLOT(start()));
+    connect(&m_selectionTimer,SIGNAL(timeout()),this,SLOT(sendSelectedFields()));
 }
 
 void Canvas::dragEnterEvent(QGraphicsSceneDragDropEvent *event)
@@ -66,7 +81,6 @@ void Canvas::dropEvent ( QGraphicsSceneDragDropEvent * event )
             {
                 SetBackgroundCommand* cmd = new SetBackgroundCommand(this,url);
                 m_undoStack->push(cmd);
-                emit imageChanged();
             }
         }
     }
@@ -94,19 +108,11 @@ void Canvas::mousePressEvent ( QGraphicsSceneMouseEvent * mouseEvent )
     {
         if(forwardEvent())
         {
-            m_oldPos.clear();
-            QPointF mousePos(mouseEvent->buttonDownScenePos(Qt::LeftButton).x(),
-                             mouseEvent->buttonDownScenePos(Qt::LeftButton).y());
-            const QList<QGraphicsItem *> itemList = items(mousePos);
-            m_movingItems.append(itemList.isEmpty() ? nullptr : itemList.first());
-
-            if (m_movingItems.first() != nullptr && mouseEvent->button() == Qt::LeftButton)
-            {
-                m_oldPos.append(m_movingItems.first()->pos());
-            }
-
+            // a drag whose release never came is closed before starting a new one
+            finishDrag();
             //clearSelection();
             QGraphicsScene::mousePressEvent(mouseEvent);
+            beginDrag(mouseEvent);
         }
         if(m_currentTool==Canvas::DELETETOOL)
         {
@@ -131,11 +137,50 @@ void Canvas::mousePressEvent ( QGraphicsSceneMouseEvent * mouseEvent )
         QGraphicsScene::mousePressEvent(mouseEvent);
     }
 }
+void Canvas::beginDrag(QGraphicsSceneMouseEvent* mouseEvent)
+{
+    // only the left button moves fields, other buttons must not open a transaction
+    if(mouseEvent->button() != Qt::LeftButton || !m_movingItems.isEmpty())
+        return;
+
+    // the selection is up to date now, a drag moves all of it.
+    const QList<QGraphicsItem *> itemList = items(mouseEvent->buttonDownScenePos(Qt::LeftButton));
+    QGraphicsItem* topItem = itemList.isEmpty() ? nullptr : itemList.first();
+    if(nullptr == topItem || topItem == m_bg)
+        return;
+
+    if(topItem->isSelected())
+    {
+        for(auto item : selectedItems())
+        {
+            if(item->flags() & QGraphicsItem::ItemIsMovable)
+                m_movingItems.append(item);
+        }
+    }
+    else
+    {
+        m_movingItems.append(topItem);
+    }
+    for(auto item : m_movingItems)
+    {
+        m_oldPos.append(item->pos());
+    }
+    if(nullptr != m_model)
+    {
+        m_model->beginTransaction();
+        m_dragTransaction = true;
+    }
+}
 void Canvas::mouseMoveEvent ( QGraphicsSceneMouseEvent * mouseEvent )
 {
     if(forwardEvent())
     {
         QGraphicsScene::mouseMoveEvent(mouseEvent);
+        // Alt drags freely
+        if(!m_movingItems.isEmpty() && (mouseEvent->buttons() & Qt::LeftButton))
+            snapMovingItems(!(mouseEvent->modifiers() & Qt::AltModifier));
+        else if(!m_movingItems.isEmpty()) // the left button was released out of our sight
+            finishDrag();
     }
     else if(m_currentItem!=nullptr)
     {
@@ -143,6 +188,201 @@ void Canvas::mouseMoveEvent ( QGraphicsSceneMouseEvent * mouseEvent )
         update();
     }
 }
+void Canvas::keyPressEvent(QKeyEvent* event)
+{
+    QPointF delta;
+    switch(event->key())
+    {
+    case Qt::Key_Left:
+        delta.setX(-1);
+        break;
+    case Qt::Key_Right:
+        delta.setX(1);
+        break;
+    case Qt::Key_Up:
+        delta.setY(-1);
+        break;
+    case Qt::Key_Down:
+        delta.setY(1);
+        break;
+    default:
+        break;
+    }
+
+    QList<QGraphicsItem*> list;
+    for(auto item : selectedItems())
+    {
+        if(item->flags() & QGraphicsItem::ItemIsMovable)
+            list.append(item);
+    }
+    if(delta.isNull() || list.isEmpty() || !forwardEvent())
+    {
+        QGraphicsScene::keyPressEvent(event);
+        return;
+    }
+
+    if(event->modifiers() & Qt::ShiftModifier)
+        delta *= 10;
+
+    QList<QPointF> oldPos;
+    if(nullptr != m_model)
+        m_model->beginTransaction();
+    for(auto item : list)
+    {
+        oldPos.append(item->pos());
+        item->setPos(item->pos()+delta);
+    }
+    m_undoStack->push(new MoveFieldCommand(list,oldPos,true));
+    if(nullptr != m_model)
+        m_model->commitTransaction();
+    event->accept();
+}
+void Canvas::sendSelectedFields()
+{
+    QList<Field*> fields;
+    for(auto item : selectedItems())
+    {
+        auto canvasField = dynamic_cast<CanvasField*>(item);
+        if(nullptr != canvasField && nullptr != canvasField->getField())
+            fields.append(canvasField->getField());
+    }
+    emit selectedFieldsChanged(fields);
+}
+void Canvas::selectFields(const QList<Field*>& fields)
+{
+    {
+        QSignalBlocker blocker(this);
+        clearSelection();
+        for(auto field : fields)
+        {
+            auto item = field->getCanvasField();
+            if(nullptr != item && item->scene() == this)
+                item->setSelected(true);
+        }
+    }
+    m_selectionTimer.stop();
+}
+void Canvas::indexField(CanvasField* field)
+{
+    if(nullptr == field->parentItem() && field->scene() == this)
+        m_index.insert(field,field->sceneBoundingRect());
+}
+void Canvas::unindexField(CanvasField* field)
+{
+    m_index.remove(field);
+}
+QRectF Canvas::guidesRect() const
+{
+    QRectF rect;
+    for(auto guide : m_guides)
+    {
+        rect |= QRectF(guide.p1(),guide.p2()).normalized();
+    }
+    if(rect.isNull())
+        return rect;
+    // the guides are cosmetic lines, one pixel wide whatever the zoom
+    qreal margin = 2;
+    for(auto view : views())
+    {
+        qreal scale = view->transform().mapRect(QRectF(0,0,1,1)).width();
+        if(scale > 0)
+            margin = qMax(margin,2/scale);
+    }
+    return rect.adjusted(-margin,-margin,margin,margin);
+}
+void Canvas::snapMovingItems(bool enabled)
+{
+    QRectF area;
+    for(auto item : m_movingItems)
+    {
+        area |= item->sceneBoundingRect();
+    }
+    QRectF oldGuides = guidesRect();
+    m_guides.clear();
+    if(enabled && !area.isNull() && !m_index.isEmpty())
+    {
+        // the fields standing still during the drag are the snap targets.
+        auto moving = m_movingItems.toSet();
+        QList<QGraphicsItem*> neighbours;
+        for(auto item : m_index.query(area.adjusted(-SNAP_RANGE,-SNAP_RANGE,SNAP_RANGE,SNAP_RANGE)))
+        {
+            if(!moving.contains(item))
+                neighbours.append(item);
+        }
+        qreal dx = SNAP_DISTANCE+1;
+        qreal dy = SNAP_DISTANCE+1;
+        const qreal xs[] = {area.left(),area.center().x(),area.right()};
+        const qreal ys[] = {area.top(),area.center().y(),area.bottom()};
+        for(auto item : neighbours)
+        {
+            QRectF target = m_index.rect(item);
+            const qreal txs[] = {target.left(),target.center().x(),target.right()};
+            const qreal tys[] = {target.top(),target.center().y(),target.bottom()};
+            for(int i = 0; i < 3; ++i)
+            {
+                for(int j = 0; j < 3; ++j)
+                {
+                    if(qAbs(txs[j]-xs[i]) < qAbs(dx))
+                        dx = txs[j]-xs[i];
+                    if(qAbs(tys[j]-ys[i]) < qAbs(dy))
+                        dy = tys[j]-ys[i];
+                }
+            }
+        }
+        if(qAbs(dx) > SNAP_DISTANCE)
+            dx = 0;
+        if(qAbs(dy) > SNAP_DISTANCE)
+            dy = 0;
+        if(!qFuzzyIsNull(dx) || !qFuzzyIsNull(dy))
+        {
+            for(auto item : m_movingItems)
+            {
+                item->moveBy(dx,dy);
+            }
+            area.translate(dx,dy);
+        }
+
+        // one guide per edge or centre shared with a neighbour
+        const qreal sxs[] = {area.left(),area.center().x(),area.right()};
+        const qreal sys[] = {area.top(),area.center().y(),area.bottom()};
+        for(auto item : neighbours)
+        {
+            QRectF target = m_index.rect(item);
+            const qreal txs[] = {target.left(),target.center().x(),target.right()};
+            const qreal tys[] = {target.top(),target.center().y(),target.bottom()};
+            for(int i = 0; i < 3; ++i)
+            {
+                for(int j = 0; j < 3; ++j)
+                {
+                    if(qAbs(txs[j]-sxs[i]) < 0.5)
+                        m_guides.append(QLineF(sxs[i],qMin(area.top(),target.top()),sxs[i],qMax(area.bottom(),target.bottom())));
+                    if(qAbs(tys[j]-sys[i]) < 0.5)
+                        m_guides.append(QLineF(qMin(area.left(),target.left()),sys[i],qMax(area.right(),target.right()),sys[i]));
+                }
+            }
+        }
+    }
+    // the moved fields repaint themselves, only the guides are left to redraw
+    if(!oldGuides.isNull())
+        update(oldGuides);
+    QRectF newGuides = guidesRect();
+    if(!newGuides.isNull())
+        update(newGuides);
+}
+void Canvas::drawForeground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsScene::drawForeground(painter,rect);
+    if(m_guides.isEmpty())
+        return;
+
+    painter->save();
+    QPen pen(Qt::magenta);
+    pen.setCosmetic(true);
+    pen.setStyle(Qt::DashLine);
+    painter->setPen(pen);
+    painter->drawLines(m_guides.toVector());
+    painter->restore();
+}
 bool Canvas::forwardEvent()
 {
     if((Canvas::MOVE == m_currentTool)||(Canvas::NONE == m_currentTool))
@@ -190,20 +430,9 @@ void Canvas::mouseReleaseEvent ( QGraphicsSceneMouseEvent * mouseEvent )
 
     if(forwardEvent())
     {
-        if(!m_movingItems.isEmpty())
-        {
-            if (m_movingItems.first() != nullptr && mouseEvent->button() == Qt::LeftButton)
-            {
-                if (m_oldPos.first() != m_movingItems.first()->pos())
-                {
-                    MoveFieldCommand* moveCmd = new MoveFieldCommand(m_movingItems,m_oldPos);
-                    m_undoStack->push(moveCmd);
-                }
-                m_movingItems.clear();
-                m_oldPos.clear();
-            }
-        }
         QGraphicsScene::mouseReleaseEvent(mouseEvent);
+        if(mouseEvent->button() == Qt::LeftButton)
+            finishDrag();
     }
     else
     {
@@ -211,6 +440,40 @@ void Canvas::mouseReleaseEvent ( QGraphicsSceneMouseEvent * mouseEvent )
         m_currentItem=nullptr;
     }
 }
+void Canvas::finishDrag()
+{
+    if(!m_movingItems.isEmpty() && m_oldPos.first() != m_movingItems.first()->pos())
+    {
+        MoveFieldCommand* moveCmd = new MoveFieldCommand(m_movingItems,m_oldPos);
+        m_undoStack->push(moveCmd);
+    }
+    if(!m_guides.isEmpty())
+        update(guidesRect());
+    m_movingItems.clear();
+    m_oldPos.clear();
+    m_guides.clear();
+    if(m_dragTransaction)
+    {
+        m_dragTransaction = false;
+        if(nullptr != m_model)
+            m_model->commitTransaction();
+    }
+}
+
+bool Canvas::event(QEvent* event)
+{
+    // the release may never reach the scene: lost grab, dialog opened during the press...
+    if(event->type() == QEvent::UngrabMouse || event->type() == QEvent::WindowDeactivate)
+        finishDrag();
+    return QGraphicsScene::event(event);
+}
+
+void Canvas::focusOutEvent(QFocusEvent* event)
+{
+    finishDrag();
+    QGraphicsScene::focusOutEvent(event);
+}
+
 void Canvas::adjustNewItem(CSItem* item)
 {
     if(nullptr == item)
@@ -253,12 +516,215 @@ void Canvas::setModel(FieldModel *model)
     m_model = model;
 }
 
-QPixmap* Canvas::pixmap()
+void Canvas::setBackground(const QByteArray& data, const QPixmap& decoded)
 {
-    return m_pix;
+    if(m_released)
+        setFieldCache(true);
+    m_backgroundData = data;
+    m_background = decoded;
+    m_released = false;
+    if(m_background.isNull() && views().isEmpty())
+    {
+        // a page out of sight is decoded when it is shown, see restoreBackground()
+        QBuffer buffer;
+        buffer.setData(m_backgroundData);
+        QImageReader reader(&buffer);
+        m_backgroundSize = reader.size();
+        m_released = true;
+    }
+    else
+    {
+        if(m_background.isNull())
+            m_background = decodeBackground();
+        m_backgroundSize = m_background.size();
+    }
+    showBackground();
+    emit imageChanged();
 }
-void Canvas::setPixmap(QPixmap* pix)
+
+void Canvas::clearBackground()
 {
-    m_pix = pix;
+    if(m_released)
+        setFieldCache(true);
+    m_released = false;
+    m_backgroundData.clear();
+    m_background = QPixmap();
+    m_backgroundSize = QSize();
+    showBackground();
     emit imageChanged();
 }
+
+bool Canvas::hasBackground() const
+{
+    return !m_backgroundData.isEmpty();
+}
+
+QPixmap Canvas::background() const
+{
+    return m_background;
+}
+
+QString Canvas::backgroundKey() const
+{
+    return m_backgroundKey;
+}
+
+void Canvas::setBackgroundKey(const QString& key)
+{
+    m_backgroundKey = key;
+}
+
+void Canvas::releaseBackground()
+{
+    if(m_released || m_background.isNull() || m_backgroundData.isEmpty())
+        return;
+
+    m_released = true;
+    m_background = QPixmap();
+    if(nullptr != m_bg)
+    {
+        m_bg->setPixmap(m_background);
+        auto tiled = dynamic_cast<TiledBackgroundItem*>(m_bg);
+        if(nullptr != tiled)
+            tiled->releaseLevels();
+    }
+    setSceneRect(QRectF(QPointF(0,0),m_backgroundSize));
+    setFieldCache(false);
+}
+
+void Canvas::restoreBackground()
+{
+    if(!m_released)
+        return;
+    m_released = false;
+
+    m_background = decodeBackground();
+    showBackground();
+    setSceneRect(QRectF(m_background.rect()));
+    setFieldCache(true);
+}
+
+void Canvas::showBackground()
+{
+    if(nullptr == m_bg)
+        return;
+    m_bg->setPixmap(m_background);
+    // the reduced levels are built in the thread pool while the page is already shown
+    auto tiled = dynamic_cast<TiledBackgroundItem*>(m_bg);
+    if(nullptr != tiled)
+        tiled->prepareLevels();
+}
+
+QPixmap Canvas::decodeBackground() const
+{
+    // the image store decodes and caches the page entry, the canvas only converts the result.
+    if(nullptr != m_imageModel && !m_backgroundKey.isEmpty())
+    {
+        auto store = m_imageModel->store();
+        if(store->imageData(m_backgroundKey).m_data.constData() == m_backgroundData.constData())
+            return QPixmap::fromImage(store->image(m_backgroundKey));
+    }
+    QPixmap pix;
+    pix.loadFromData(m_backgroundData);
+    return pix;
+}
+
+void Canvas::setFieldCache(bool enabled)
+{
+    auto mode = enabled ? QGraphicsItem::DeviceCoordinateCache : QGraphicsItem::NoCache;
+    for(auto item : items())
+    {
+        if(nullptr != dynamic_cast<CanvasField*>(item) && item->cacheMode() != mode)
+            item->setCacheMode(mode);
+    }
+}
+
+bool Canvas::isReleased() const
+{
+    return m_released;
+}
+
+void Canvas::releaseFields()
+{
+    if(m_fieldsReleased || nullptr == m_model)
+        return;
+    m_fieldsReleased = true;
+
+    QList<CharacterSheetItem*> list;
+    m_model->getFieldFromPage(m_currentPage,list);
+    for(auto item : list)
+    {
+        auto field = dynamic_cast<Field*>(item);
+        if(nullptr == field)
+            continue;
+        auto canvasField = field->getCanvasField();
+        // children go with their parent, the undo commands keep pointing to the item
+        if(nullptr == canvasField || nullptr != canvasField->parentItem() || canvasField->scene() != this)
+            continue;
+        canvasField->setCacheMode(QGraphicsItem::NoCache);
+        removeItem(canvasField);
+    }
+}
+
+void Canvas::restoreFields()
+{
+    if(!m_fieldsReleased || nullptr == m_model)
+        return;
+    m_fieldsReleased = false;
+
+    auto mode = m_released ? QGraphicsItem::NoCache : QGraphicsItem::DeviceCoordinateCache;
+    QList<CharacterSheetItem*> list;
+    m_model->getFieldFromPage(m_currentPage,list);
+    for(auto item : list)
+    {
+        auto field = dynamic_cast<Field*>(item);
+        if(nullptr == field)
+            continue;
+        auto canvasField = field->getCanvasField();
+        // an undo may have put it back already
+        if(nullptr == canvasField || nullptr != canvasField->parentItem() || nullptr != canvasField->scene())
+            continue;
+        addItem(canvasField);
+        canvasField->setCacheMode(mode);
+    }
+}
+
+bool Canvas::fieldsReleased() const
+{
+    return m_fieldsReleased;
+}
+
+QByteArray Canvas::backgroundData() const
+{
+    return m_backgroundData;
+}
+
+QSize Canvas::backgroundSize() const
+{
+    return m_backgroundSize;
+}
+
+qint64 Canvas::memoryCost() const
+{
+    qint64 cost = 0;
+    if(!m_background.isNull())
+    {
+        // decoded background and its reduced levels (a third more)
+        cost = static_cast<qint64>(m_background.width())*m_background.height()*m_background.depth()/8;
+        cost += cost/3;
+    }
+    if(m_fieldsReleased)
+        return cost;
+    // the field items and their cached renderings, at zoom 1
+    for(auto item : items())
+    {
+        if(nullptr == dynamic_cast<CanvasField*>(item) || nullptr != item->parentItem())
+            continue;
+        cost += sizeof(CanvasField);
+        if(item->cacheMode() == QGraphicsItem::NoCache)
+            continue;
+        QSizeF size = item->boundingRect().size();
+        cost += static_cast<qint64>(size.width()*size.height())*4;
+    }
+    return cost;
+}
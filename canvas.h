@@ -25,13 +25,17 @@
 #include <QGraphicsScene>
 #include <QGraphicsItem>
 #include <QGraphicsPixmapItem>
+#include <QLineF>
+#include <QTimer>
 #include <QUndoStack>
 
 #include "field.h"
 #include "fieldmodel.h"
+#include "spatialindex.h"
 
 
 class ImageModel;
+class CanvasField;
 class Canvas : public QGraphicsScene
 {
     Q_OBJECT
@@ -43,9 +47,20 @@ public:
     FieldModel *model() const;
     void setModel(FieldModel *model);
 
-    QPixmap* pixmap();
-
-    void setPixmap(QPixmap* pix);
+    /**
+     * @brief setBackground shows the encoded image as the page background.
+     * @param data encoded image, the canvas keeps it to decode it again after releaseBackground().
+     * @param decoded data already decoded, if known.
+     */
+    void setBackground(const QByteArray& data, const QPixmap& decoded = QPixmap());
+    void clearBackground();
+    bool hasBackground() const;
+    QPixmap background() const;
+    /**
+     * @brief backgroundKey key of the background in the image model, empty until it is stored there.
+     */
+    QString backgroundKey() const;
+    void setBackgroundKey(const QString& key);
     int currentPage() const;
     void setCurrentPage(int currentPage);
 
@@ -62,9 +77,45 @@ public:
    ImageModel *getImageModel() const;
    void setImageModel(ImageModel *imageModel);
 
+   /**
+    * @brief releaseBackground frees the decoded background and the cached field renderings.
+    * The encoded background is kept to decode it again in restoreBackground().
+    */
+   void releaseBackground();
+   void restoreBackground();
+   bool isReleased() const;
+   /**
+    * @brief releaseFields takes the field items of the page out of the scene.
+    * The fields stay in the FieldModel, restoreFields() puts their items back from it.
+    */
+   void releaseFields();
+   void restoreFields();
+   bool fieldsReleased() const;
+   QByteArray backgroundData() const;
+   QSize backgroundSize() const;
+   qint64 memoryCost() const;
+
+   /**
+    * @brief selectFields replaces the selection without sending selectedFieldsChanged().
+    */
+   void selectFields(const QList<Field*>& fields);
+
+   /**
+    * @brief indexField puts a top level field, or its new geometry, in the snap index.
+    */
+   void indexField(CanvasField* field);
+   void unindexField(CanvasField* field);
+
 signals:
    void imageChanged();
    void itemDeleted(QGraphicsItem*);
+   /**
+    * @brief selectedFieldsChanged is sent once per event loop turn, whatever the number of selection changes.
+    */
+   void selectedFieldsChanged(const QList<Field*>& fields);
+
+private slots:
+   void sendSelectedFields();
 
 protected:
     void dragEnterEvent ( QGraphicsSceneDragDropEvent * event );
@@ -73,22 +124,44 @@ protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent);
     void mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent);
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent);
+    void keyPressEvent(QKeyEvent* event);
+    void focusOutEvent(QFocusEvent* event);
+    bool event(QEvent* event);
+    void drawForeground(QPainter* painter, const QRectF& rect);
 
 
 private:
     void adjustNewItem(CSItem *item);
     bool forwardEvent();
+    void beginDrag(QGraphicsSceneMouseEvent* mouseEvent);
+    void snapMovingItems(bool enabled);
+    void setFieldCache(bool enabled);
+    QPixmap decodeBackground() const;
+    void showBackground();
+    QRectF guidesRect() const;
+    void finishDrag();
 private:
     QGraphicsPixmapItem* m_bg;
     CSItem* m_currentItem;
     Tool m_currentTool;
-    QPixmap* m_pix;
     FieldModel* m_model;
     int m_currentPage;
     QUndoStack* m_undoStack;
     QList<QGraphicsItem*> m_movingItems;
     QList<QPointF> m_oldPos;
+    bool m_dragTransaction = false;
     ImageModel* m_imageModel = nullptr;
+    // every top level field of the page, maintained by the fields themselves
+    SpatialIndex m_index;
+    QList<QLineF> m_guides;
+    QTimer m_selectionTimer;
+    // the canvas owns its decoded background, the undo commands only keep the encoded one
+    QPixmap m_background;
+    QByteArray m_backgroundData;
+    QString m_backgroundKey;
+    QSize m_backgroundSize;
+    bool m_released = false;
+    bool m_fieldsReleased = false;
 };
 
 #endif // CANVAS_H
@@ -4,6 +4,7 @@
 #include <QGraphicsSceneContextMenuEvent>
 #include <QDebug>
 #include "field.h"
+#include "canvas.h"
 
 QHash<int,QString> CanvasField::m_pictureMap({{Field::TEXTINPUT, ":/resources/icons/Actions-edit-rename-icon.png"},
                                               {Field::TEXTAREA, ":/resources/icons/textarea.png"},
@@ -14,19 +15,56 @@ QHash<int,QString> CanvasField::m_pictureMap({{Field::TEXTINPUT, ":/resources/ic
                                               {Field::WEBPAGE,":/resources/icons/webPage.svg"},
                                               {Field::DICEBUTTON,""}});
 
+QHash<QPair<int,int>,QPixmap> CanvasField::m_iconCache;
+
 bool CanvasField::m_showImageField = true;
+#define ICON_SIZE 32
 
 CanvasField::CanvasField(Field* field)
-    : m_field(field)
+    : m_field(nullptr)
 {
     m_rect.setCoords(0,0,0,0);
-    setFlags(QGraphicsItem::ItemIsMovable | QGraphicsItem::ItemIsSelectable | QGraphicsItem::ItemIsFocusable );
+    setFlags(QGraphicsItem::ItemIsMovable | QGraphicsItem::ItemIsSelectable | QGraphicsItem::ItemIsFocusable | QGraphicsItem::ItemSendsGeometryChanges);
+    // the field is drawn once, then blitted until a property or the geometry changes.
+    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    m_label.setPerformanceHint(QStaticText::AggressiveCaching);
+    setField(field);
+}
+CanvasField::~CanvasField()
+{
+    auto canvas = dynamic_cast<Canvas*>(scene());
+    if(nullptr != canvas)
+        canvas->unindexField(this);
+}
+QVariant CanvasField::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    // the canvas snap index follows the field from scene to scene and on each move
+    if(change == ItemSceneChange)
+    {
+        auto canvas = dynamic_cast<Canvas*>(scene());
+        if(nullptr != canvas)
+            canvas->unindexField(this);
+    }
+    else if(change == ItemSceneHasChanged || change == ItemPositionHasChanged)
+    {
+        updateIndex();
+    }
+    return QGraphicsObject::itemChange(change,value);
+}
+void CanvasField::updateIndex()
+{
+    auto canvas = dynamic_cast<Canvas*>(scene());
+    if(nullptr != canvas)
+        canvas->indexField(this);
 }
 void CanvasField::setNewEnd(QPointF nend)
 {
+    prepareGeometryChange();
+    m_rect.setBottomRight(nend);
+    updateIndex();
+    m_labelDirty = true;
     emit widthChanged();
     emit heightChanged();
-    m_rect.setBottomRight(nend);
 }
 Field* CanvasField::getField() const
 {
@@ -35,7 +73,21 @@ Field* CanvasField::getField() const
 
 void CanvasField::setField(Field* field)
 {
+    if(m_field == field)
+        return;
+
+    if(nullptr != m_field)
+        disconnect(m_field,SIGNAL(updateNeeded(CSItem*)),this,SLOT(invalidate()));
     m_field = field;
+    if(nullptr != m_field)
+        connect(m_field,SIGNAL(updateNeeded(CSItem*)),this,SLOT(invalidate()));
+    invalidate();
+}
+
+void CanvasField::invalidate()
+{
+    m_labelDirty = true;
+    update();
 }
 QRectF CanvasField::boundingRect() const
 {
@@ -76,60 +128,73 @@ void CanvasField::paint ( QPainter * painter, const QStyleOptionGraphicsItem * o
         pen.setColor(Qt::red);
         pen.setWidth(5);
         painter->setPen(pen);
-        painter->drawRect(m_rect);
+        // inset by half the pen width, the frame stays inside the bounding rect
+        painter->drawRect(m_rect.adjusted(2.5,2.5,-2.5,-2.5));
         painter->restore();
     }
 
-    int flags =0;
-    Field::TextAlign align = m_field->getTextAlignValue();
-    if(align <3)
+    if(m_showImageField)
     {
-        flags = Qt::AlignTop;
-    }
-    else if(align <6)
-    {
-        flags = Qt::AlignVCenter;
-    }
-    else
-    {
-        flags = Qt::AlignBottom;
+        QPixmap pix = typeIcon(m_field->getFieldType(),painter->device()->devicePixelRatioF());
+        if(!pix.isNull())
+        {
+            painter->drawPixmap(m_rect.center()-QPointF(ICON_SIZE/2,ICON_SIZE/2),pix);
+        }
     }
 
-    if(align%3==0)
+    if(m_labelDirty)
     {
-        flags |= Qt::AlignRight;
-    }
-    else if(align%3==1)
-    {
-        flags |= Qt::AlignHCenter;
-    }
-    else
-    {
-        flags |= Qt::AlignLeft;
-    }
+        int flags =0;
+        Field::TextAlign align = m_field->getTextAlignValue();
+        if(align <3)
+        {
+            flags = Qt::AlignTop;
+        }
+        else if(align <6)
+        {
+            flags = Qt::AlignVCenter;
+        }
+        else
+        {
+            flags = Qt::AlignBottom;
+        }
 
-    if(m_pix.isNull()||m_currentType!=m_field->getFieldType())
-    {
-        QPixmap map = QPixmap(m_pictureMap[m_field->getFieldType()]);
-        if(!map.isNull())
+        if(align%3==0)
         {
-            m_pix=map.scaled(32,32);
-            m_currentType = m_field->getFieldType();
+            flags |= Qt::AlignRight;
         }
+        else if(align%3==1)
+        {
+            flags |= Qt::AlignHCenter;
+        }
+        else
+        {
+            flags |= Qt::AlignLeft;
+        }
+        m_labelFlags = flags;
+        m_label.setText(m_field->getId());
+        m_label.setTextFormat(Qt::PlainText);
+        m_label.setTextWidth(m_rect.width());
+        m_label.setTextOption(QTextOption(static_cast<Qt::Alignment>(flags & Qt::AlignHorizontal_Mask)));
+        m_labelDirty = false;
     }
-    if((!m_pix.isNull())&& m_showImageField )
-    {
-        painter->drawPixmap(m_rect.center()-m_pix.rect().center(),m_pix,m_pix.rect());
-    }
-
-    painter->drawText(m_rect,flags,m_field->getId());
+    // QStaticText only aligns horizontally, the vertical offset is computed here.
+    qreal y = m_rect.top();
+    if(m_labelFlags & Qt::AlignVCenter)
+        y += (m_rect.height()-m_label.size().height())/2;
+    else if(m_labelFlags & Qt::AlignBottom)
+        y += m_rect.height()-m_label.size().height();
+    painter->drawStaticText(QPointF(m_rect.left(),y),m_label);
     painter->restore();
 }
 void CanvasField::setWidth(qreal w)
 {
     if(w!=m_rect.width())
     {
+        prepareGeometryChange();
         m_rect.setWidth(w);
+        updateIndex();
+        m_labelDirty = true;
         emit widthChanged();
         update();
     }
@@ -138,7 +203,10 @@ void CanvasField::setHeight(qreal h)
 {
     if(h!=m_rect.height())
     {
+        prepareGeometryChange();
         m_rect.setHeight(h);
+        updateIndex();
+        m_labelDirty = true;
         emit heightChanged();
         update();
     }
@@ -154,6 +222,26 @@ void CanvasField::setShowImageField(bool showImageField)
     m_showImageField = showImageField;
 }
 
+QPixmap CanvasField::typeIcon(int type, qreal devicePixelRatio)
+{
+    // loaded and scaled once per type and screen density, paint() only draws.
+    auto key = qMakePair(type,qRound(devicePixelRatio*100));
+    auto it = m_iconCache.find(key);
+    if(it != m_iconCache.end())
+        return it.value();
+
+    QPixmap pix;
+    QPixmap map(m_pictureMap.value(type));
+    if(!map.isNull())
+    {
+        int size = qRound(ICON_SIZE*devicePixelRatio);
+        pix = map.scaled(size,size,Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
+        pix.setDevicePixelRatio(devicePixelRatio);
+    }
+    m_iconCache.insert(key,pix);
+    return pix;
+}
+
 void CanvasField::setMenu(QMenu &menu)
 {
     Q_UNUSED(menu);
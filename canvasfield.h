@@ -2,6 +2,7 @@
 #define CANVASFIELD_H
 #include <QGraphicsObject>
 #include <QMenu>
+#include <QStaticText>
 //
 class Field;
 /**
@@ -12,6 +13,7 @@ class CanvasField : public QGraphicsObject
     Q_OBJECT
 public:
     CanvasField(Field* field);
+    virtual ~CanvasField();
 
     Field* getField() const;
     void setField(Field* field);
@@ -27,20 +29,31 @@ public:
 
     static bool getShowImageField();
     static void setShowImageField(bool showImageField);
+
+    static QPixmap typeIcon(int type, qreal devicePixelRatio);
     virtual void setMenu(QMenu& menu);
 
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
+public slots:
+    void invalidate();
 
 signals:
     void widthChanged();
     void heightChanged();
 
+protected:
+    void updateIndex();
+
 protected:
     Field* m_field;
     QRectF m_rect;
+    QStaticText m_label;
+    int m_labelFlags = 0;
+    bool m_labelDirty = true;
     static QHash<int,QString> m_pictureMap;
+    static QHash<QPair<int,int>,QPixmap> m_iconCache;
     static bool m_showImageField;
-    QPixmap m_pix;
-    int m_currentType;
 };
 
 #endif // CANVASFIELD_H
@@ -0,0 +1,43 @@
+/***************************************************************************
+    *   Copyright (C) 2019 by Renaud Guezennec                                *
+    *   http://www.rolisteam.org/contact                                      *
+    *                                                                         *
+    *   rolisteam is free software; you can redistribute it and/or modify     *
+    *   it under the terms of the GNU General Public License as published by  *
+    *   the Free Software Foundation; either version 2 of the License, or     *
+    *   (at your option) any later version.                                   *
+    *                                                                         *
+    *   This program is distributed in the hope that it will be useful,       *
+    *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+    *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+    *   GNU General Public License for more details.                          *
+    *                                                                         *
+    *   You should have received a copy of the GNU General Public License     *
+    *   along with this program; if not, write to the                         *
+    *   Free Software Foundation, Inc.,                                       *
+    *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+    ***************************************************************************/
+#ifndef ENCODINGDELEGATE_H
+#define ENCODINGDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QWidget>
+
+/**
+ * @brief The EncodingDelegate class selects how an image is written into the .rcs file.
+ */
+class EncodingDelegate : public QStyledItemDelegate
+{
+public:
+    EncodingDelegate(QWidget* parent = nullptr);
+
+    QWidget *createEditor(QWidget * parent, const QStyleOptionViewItem & option, const QModelIndex & index) const;
+    void setEditorData(QWidget * editor, const QModelIndex & index) const;
+    void setModelData(QWidget * editor, QAbstractItemModel * model, const QModelIndex & index) const;
+    QString displayText(const QVariant &value, const QLocale &locale) const;
+
+private:
+    QStringList m_data;
+};
+
+#endif // ENCODINGDELEGATE_H
@@ -0,0 +1,55 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include "duplicatedialog.h"
+#include "ui_duplicatedialog.h"
+
+DuplicateDialog::DuplicateDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DuplicateDialog)
+{
+    ui->setupUi(this);
+}
+
+DuplicateDialog::~DuplicateDialog()
+{
+    delete ui;
+}
+
+int DuplicateDialog::rows() const
+{
+    return ui->m_rows->value();
+}
+
+int DuplicateDialog::columns() const
+{
+    return ui->m_columns->value();
+}
+
+qreal DuplicateDialog::horizontalSpacing() const
+{
+    return ui->m_hSpacing->value();
+}
+
+qreal DuplicateDialog::verticalSpacing() const
+{
+    return ui->m_vSpacing->value();
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#ifndef DUPLICATEDIALOG_H
+#define DUPLICATEDIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class DuplicateDialog;
+}
+/**
+ * @brief The DuplicateDialog class asks for the grid the selected fields are copied into.
+ */
+class DuplicateDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DuplicateDialog(QWidget *parent = nullptr);
+    ~DuplicateDialog();
+
+    int rows() const;
+    int columns() const;
+    qreal horizontalSpacing() const;
+    qreal verticalSpacing() const;
+
+private:
+    Ui::DuplicateDialog *ui;
+};
+
+#endif // DUPLICATEDIALOG_H
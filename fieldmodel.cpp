@@ -24,6 +24,8 @@
 #include <QDebug>
 #include <QJsonArray>
 #include <QGraphicsScene>
+#include <algorithm>
+#include <functional>
 
 #include "canvas.h"
 #include "qmlgeneratorvisitor.h"
@@ -171,9 +173,7 @@ QModelIndex FieldModel::parent(const QModelIndex &child) const
     if (parentItem == m_rootSection)
         return QModelIndex();
 
-    CharacterSheetItem* grandParent = parentItem->getParent();
-
-    return createIndex(grandParent->indexOfChild(parentItem), 0, parentItem);
+    return createIndex(rowOf(parentItem), 0, parentItem);
 }
 
 int FieldModel::rowCount(const QModelIndex &parent) const
@@ -218,9 +218,11 @@ bool FieldModel::setData(const QModelIndex &index, const QVariant &value, int ro
 
         if(nullptr!=item)
         {
-            item->setValueFrom(m_colunm[index.column()]->getPos(),value);
+            auto column = m_colunm[index.column()]->getPos();
+            item->setValueFrom(column,value);
+            propagateEdit(QList<CharacterSheetItem*>() << item,column);
             emit valuesChanged(item->getValueFrom(CharacterSheetItem::ID,Qt::DisplayRole).toString(),value.toString());
-            emit modelChanged();
+            notifyModelChanged();
             return true;
         }
     }
@@ -232,8 +234,35 @@ void FieldModel::appendField(CSItem *f)
     beginInsertRows(QModelIndex(),m_rootSection->getChildrenCount(),m_rootSection->getChildrenCount());
     m_rootSection->appendChild(f);
     connect(f,SIGNAL(updateNeeded(CSItem*)),this,SLOT(updateItem(CSItem*)));
+    if(!m_indexDirty)
+        indexItem(f,m_rootSection->getChildrenCount()-1);
+    addToPageIndex(f);
+    endInsertRows();
+    emit fieldsAdded(QList<CharacterSheetItem*>() << f);
+    emit definitionChanged();
+    notifyModelChanged();
+}
+void FieldModel::appendFields(const QList<CSItem*>& fields)
+{
+    if(fields.isEmpty())
+        return;
+
+    int first = m_rootSection->getChildrenCount();
+    beginInsertRows(QModelIndex(),first,first+fields.size()-1);
+    QList<CharacterSheetItem*> added;
+    for(auto f : fields)
+    {
+        m_rootSection->appendChild(f);
+        connect(f,SIGNAL(updateNeeded(CSItem*)),this,SLOT(updateItem(CSItem*)));
+        if(!m_indexDirty)
+            indexItem(f,m_rootSection->getChildrenCount()-1);
+        addToPageIndex(f);
+        added.append(f);
+    }
     endInsertRows();
-    emit modelChanged();
+    emit fieldsAdded(added);
+    emit definitionChanged();
+    notifyModelChanged();
 }
 void FieldModel::insertField(CSItem* field, CharacterSheetItem* parent, int pos)
 {
@@ -241,9 +270,20 @@ void FieldModel::insertField(CSItem* field, CharacterSheetItem* parent, int pos)
     if(parent == m_rootSection)
     {
         m_rootSection->insertChild(field,pos);
+        if(!m_indexDirty)
+        {
+            indexItem(field,pos);
+            reindexRows(m_rootSection,pos+1);
+        }
+        addToPageIndex(field);
     }
     endInsertRows();
-    emit modelChanged();
+    if(parent == m_rootSection)
+    {
+        emit fieldsAdded(QList<CharacterSheetItem*>() << field);
+        emit definitionChanged();
+    }
+    notifyModelChanged();
 }
 Qt::ItemFlags FieldModel::flags ( const QModelIndex & index ) const
 {
@@ -267,18 +307,22 @@ Qt::ItemFlags FieldModel::flags ( const QModelIndex & index ) const
         return Qt::ItemIsEnabled | Qt::ItemIsSelectable /*| Qt::ItemIsUserCheckable */;
 
 }
-void FieldModel::generateQML(QTextStream& out,int indentation,bool isTable)
+void FieldModel::generateQML(QTextStream& out,int indentation,bool isTable,const QHash<QString,QRect>& atlas)
 {
     QmlGeneratorVisitor visitor(out,m_rootSection);
     visitor.setIndentation(indentation);
     visitor.setIsTable(isTable);
+    visitor.setAtlas(atlas);
     visitor.generateCharacterSheetItem();
     //m_rootSection->generateQML(out,CharacterSheetItem::FieldSec,0,isTable);
 }
 
 QString FieldModel::getValue(const QString &key)
 {
-    return key;
+    auto item = itemById(key);
+    if(nullptr == item)
+        return QString();
+    return item->getValueFrom(CharacterSheetItem::VALUE,Qt::DisplayRole).toString();
 }
 
 QList<CharacterSheetItem *> FieldModel::children()
@@ -293,7 +337,93 @@ QList<CharacterSheetItem *> FieldModel::children()
 
 void FieldModel::getFieldFromPage(int pagePos, QList<CharacterSheetItem*>& list)
 {
-    m_rootSection->getFieldFromPage(pagePos,list);
+    auto fields = m_pageIndex.value(pagePos).toList();
+    // callers such as DeleteFieldCommand reinsert them by row, keep the model order.
+    std::sort(fields.begin(),fields.end(),[this](CharacterSheetItem* a, CharacterSheetItem* b){
+        return rowOf(a) < rowOf(b);
+    });
+    list.append(fields);
+}
+
+void FieldModel::removePageId(int page)
+{
+    auto pages = m_pageIndex.keys();
+    std::sort(pages.begin(),pages.end());
+    beginTransaction();
+    for(int p : pages)
+    {
+        if(p <= page)
+            continue;
+        auto fields = m_pageIndex.take(p);
+        for(auto field : fields)
+        {
+            field->setPage(p-1);
+            m_pageOf.insert(field,p-1);
+        }
+        m_pageIndex[p-1].unite(fields);
+    }
+    commitTransaction();
+}
+
+void FieldModel::insertPageId(int page)
+{
+    auto pages = m_pageIndex.keys();
+    std::sort(pages.begin(),pages.end(),std::greater<int>());
+    beginTransaction();
+    for(int p : pages)
+    {
+        if(p < page)
+            continue;
+        auto fields = m_pageIndex.take(p);
+        for(auto field : fields)
+        {
+            field->setPage(p+1);
+            m_pageOf.insert(field,p+1);
+        }
+        m_pageIndex[p+1].unite(fields);
+    }
+    commitTransaction();
+}
+
+void FieldModel::addToPageIndex(CharacterSheetItem* item)
+{
+    int page = item->getPage();
+    m_pageOf.insert(item,page);
+    m_pageIndex[page].insert(item);
+}
+
+void FieldModel::removeFromPageIndex(CharacterSheetItem* item)
+{
+    auto it = m_pageOf.find(item);
+    if(it == m_pageOf.end())
+        return;
+    auto fields = m_pageIndex.find(it.value());
+    if(fields != m_pageIndex.end())
+    {
+        fields.value().remove(item);
+        if(fields.value().isEmpty())
+            m_pageIndex.erase(fields);
+    }
+    m_pageOf.erase(it);
+}
+
+void FieldModel::checkPage(CharacterSheetItem* item)
+{
+    auto it = m_pageOf.find(item);
+    if(it == m_pageOf.end() || it.value() == item->getPage())
+        return;
+    removeFromPageIndex(item);
+    addToPageIndex(item);
+}
+
+void FieldModel::rebuildPageIndex()
+{
+    m_pageIndex.clear();
+    m_pageOf.clear();
+    for(int i = 0; i < m_rootSection->getChildrenCount(); ++i)
+    {
+        addToPageIndex(m_rootSection->getChildAt(i));
+    }
 }
 
 Field* FieldModel::getFieldFromIndex(const QModelIndex &index)
@@ -301,13 +431,295 @@ Field* FieldModel::getFieldFromIndex(const QModelIndex &index)
     return static_cast<Field*>(index.internalPointer());
 }
 
+QModelIndex FieldModel::indexOf(CSItem* item) const
+{
+    if(nullptr == item || item->getParent() != m_rootSection)
+        return QModelIndex();
+    int row = rowOf(item);
+    if(row < 0)
+        return QModelIndex();
+    return createIndex(row,0,item);
+}
+
+CharacterSheetItem* FieldModel::itemById(const QString& id) const
+{
+    ensureIndex();
+    return m_idIndex.value(id);
+}
+
+int FieldModel::rowOf(const CharacterSheetItem* item) const
+{
+    ensureIndex();
+    return m_rowIndex.value(item,-1);
+}
+
+void FieldModel::checkRename(CharacterSheetItem* item)
+{
+    QString id = item->getId();
+    auto it = m_idOf.find(item);
+    if(it == m_idOf.end())
+    {
+        m_idOf.insert(item,id);
+        return;
+    }
+    if(it.value() == id)
+        return;
+
+    if(!m_indexDirty)
+    {
+        auto indexed = m_idIndex.find(it.value());
+        if(indexed != m_idIndex.end() && indexed.value() == item)
+            m_idIndex.erase(indexed);
+        m_idIndex.insert(id,item);
+    }
+    QString oldId = it.value();
+    it.value() = id;
+    emit fieldRenamed(item,oldId,id);
+    emit definitionChanged();
+}
+
+void FieldModel::checkRetype(CharacterSheetItem* item)
+{
+    int type = item->getValueFrom(CharacterSheetItem::TYPE,Qt::EditRole).toInt();
+    auto it = m_typeOf.find(item);
+    if(it == m_typeOf.end())
+    {
+        m_typeOf.insert(item,type);
+        return;
+    }
+    if(it.value() == type)
+        return;
+
+    int oldType = it.value();
+    it.value() = type;
+    emit fieldRetyped(item,oldType,type);
+    emit definitionChanged();
+}
+
+void FieldModel::propagateEdit(const QList<CharacterSheetItem*>& items, CharacterSheetItem::ColumnId column)
+{
+    // only the definition of a field matters to the characters, not its look or geometry.
+    switch(column)
+    {
+    case CharacterSheetItem::ID:
+        for(auto item : items)
+        {
+            checkRename(item);
+        }
+        break;
+    case CharacterSheetItem::TYPE:
+        for(auto item : items)
+        {
+            checkRetype(item);
+        }
+        break;
+    case CharacterSheetItem::LABEL:
+    case CharacterSheetItem::VALUE:
+    case CharacterSheetItem::VALUES:
+        for(auto item : items)
+        {
+            emit fieldRedefined(item,column);
+        }
+        if(!items.isEmpty())
+            emit definitionChanged();
+        break;
+    default:
+        break;
+    }
+}
+
+void FieldModel::unindexItem(CharacterSheetItem* item)
+{
+    auto csItem = dynamic_cast<CSItem*>(item);
+    if(nullptr != csItem)
+        m_pendingItems.remove(csItem);
+    dropFromIndex(item);
+}
+
+void FieldModel::dropFromIndex(CharacterSheetItem* item)
+{
+    // the subtree is the one recorded by indexItem(), the children may be freed already
+    for(auto child : m_childrenOf.take(item))
+    {
+        dropFromIndex(child);
+    }
+    auto id = m_idOf.find(item);
+    if(id != m_idOf.end())
+    {
+        auto indexed = m_idIndex.find(id.value());
+        if(indexed != m_idIndex.end() && indexed.value() == item)
+            m_idIndex.erase(indexed);
+        m_idOf.erase(id);
+    }
+    m_typeOf.remove(item);
+    m_rowIndex.remove(item);
+}
+
+void FieldModel::reindexRows(CharacterSheetItem* parent, int from)
+{
+    if(m_indexDirty)
+        return;
+    for(int i = qMax(0,from); i < parent->getChildrenCount(); ++i)
+    {
+        m_rowIndex.insert(parent->getChildAt(i),i);
+    }
+}
+
+void FieldModel::reindexChildren(CharacterSheetItem* item)
+{
+    if(m_indexDirty)
+        return;
+    QList<CharacterSheetItem*> children;
+    for(int i = 0; i < item->getChildrenCount(); ++i)
+    {
+        children.append(item->getChildAt(i));
+    }
+    if(children == m_childrenOf.value(item))
+        return;
+
+    // a table regenerates its sub-items, forget the old ones before indexing the new ones
+    for(auto child : m_childrenOf.take(item))
+    {
+        dropFromIndex(child);
+    }
+    for(int i = 0; i < children.size(); ++i)
+    {
+        indexItem(children.at(i),i);
+    }
+    if(!children.isEmpty())
+        m_childrenOf.insert(item,children);
+}
+
+void FieldModel::invalidateIndex()
+{
+    m_indexDirty = true;
+}
+
+void FieldModel::ensureIndex() const
+{
+    if(!m_indexDirty)
+        return;
+    // the last seen ids and types of the items still in the tree survive, to detect their edits
+    auto idOf = m_idOf;
+    auto typeOf = m_typeOf;
+    m_idOf.clear();
+    m_typeOf.clear();
+    m_idIndex.clear();
+    m_rowIndex.clear();
+    m_childrenOf.clear();
+    std::function<void(CharacterSheetItem*)> keepIds = [&](CharacterSheetItem* item){
+        auto it = idOf.constFind(item);
+        if(it != idOf.constEnd())
+            m_idOf.insert(item,it.value());
+        auto type = typeOf.constFind(item);
+        if(type != typeOf.constEnd())
+            m_typeOf.insert(item,type.value());
+        for(int i = 0; i < item->getChildrenCount(); ++i)
+        {
+            keepIds(item->getChildAt(i));
+        }
+    };
+    for(int i = 0; i < m_rootSection->getChildrenCount(); ++i)
+    {
+        keepIds(m_rootSection->getChildAt(i));
+        indexItem(m_rootSection->getChildAt(i),i);
+    }
+    m_indexDirty = false;
+}
+
+void FieldModel::indexItem(CharacterSheetItem* item, int row) const
+{
+    if(nullptr == item)
+        return;
+    QString id = item->getId();
+    m_rowIndex.insert(item,row);
+    m_idIndex.insert(id,item);
+    if(!m_idOf.contains(item))
+        m_idOf.insert(item,id);
+    if(!m_typeOf.contains(item))
+        m_typeOf.insert(item,item->getValueFrom(CharacterSheetItem::TYPE,Qt::EditRole).toInt());
+    QList<CharacterSheetItem*> children;
+    for(int i = 0; i < item->getChildrenCount(); ++i)
+    {
+        children.append(item->getChildAt(i));
+        indexItem(item->getChildAt(i),i);
+    }
+    if(!children.isEmpty())
+        m_childrenOf.insert(item,children);
+}
+
+void FieldModel::beginTransaction()
+{
+    ++m_transactionDepth;
+}
+
+void FieldModel::commitTransaction()
+{
+    if(m_transactionDepth == 0)
+        return;
+    if(--m_transactionDepth > 0)
+        return;
+
+    auto pending = m_pendingItems;
+    m_pendingItems.clear();
+    bool changed = m_pendingModelChanged;
+    m_pendingModelChanged = false;
+
+    // one range per parent, from the first to the last changed row
+    QHash<CharacterSheetItem*,QPair<int,int>> ranges;
+    for(auto item : pending)
+    {
+        reindexChildren(item);
+        checkRename(item);
+        checkRetype(item);
+        checkPage(item);
+        int row = rowOf(item);
+        CharacterSheetItem* parent = item->getParent();
+        if(row < 0 || nullptr == parent)
+            continue;
+        auto it = ranges.find(parent);
+        if(it == ranges.end())
+            ranges.insert(parent,qMakePair(row,row));
+        else
+            it.value() = qMakePair(qMin(it.value().first,row),qMax(it.value().second,row));
+    }
+    for(auto it = ranges.constBegin(); it != ranges.constEnd(); ++it)
+    {
+        CharacterSheetItem* parent = it.key();
+        QModelIndex parentIndex;
+        if(parent != m_rootSection)
+            parentIndex = createIndex(rowOf(parent),0,parent);
+        emit dataChanged(index(it.value().first,0,parentIndex),index(it.value().second,m_colunm.size()-1,parentIndex));
+    }
+    if(changed || !ranges.isEmpty())
+        emit modelChanged();
+}
+
+void FieldModel::notifyModelChanged()
+{
+    if(m_transactionDepth > 0)
+        m_pendingModelChanged = true;
+    else
+        emit modelChanged();
+}
+
 void FieldModel::updateItem(CSItem* item)
 {
-    int ind = m_rootSection->indexOfChild(item);
+    if(m_transactionDepth > 0)
+    {
+        m_pendingItems.insert(item);
+        return;
+    }
+    // the id may have been edited outside of setData (undo, property commands)
+    reindexChildren(item);
+    checkRename(item);
+    checkRetype(item);
+    checkPage(item);
+    int ind = item->getParent() == m_rootSection ? rowOf(item) : -1;
     if(ind>=0)
     {
         emit dataChanged(createIndex(ind,0,item),createIndex(ind,m_colunm.size(),item));
-        emit modelChanged();
+        notifyModelChanged();
     }
     else
     {
@@ -337,12 +749,12 @@ void FieldModel::updateItem(CSItem* item)
 
             if(itemtmp==m_rootSection)
             {
-                first = index(itemtmp->indexOfChild(next),0,first);
-                second = index(itemtmp->indexOfChild(next),m_colunm.size(),second);
+                first = index(rowOf(next),0,first);
+                second = index(rowOf(next),m_colunm.size(),second);
             }
         }
         emit dataChanged(first,second);
-        emit modelChanged();
+        notifyModelChanged();
     }
 }
 
@@ -354,6 +766,10 @@ Section* FieldModel::getRootSection() const
 void FieldModel::setRootSection(Section *rootSection)
 {
     m_rootSection = rootSection;
+    m_idOf.clear();
+    m_typeOf.clear();
+    invalidateIndex();
+    rebuildPageIndex();
 }
 void FieldModel::save(QJsonObject& json,bool exp)
 {
@@ -365,6 +781,14 @@ void FieldModel::load(QJsonObject &json,QList<QGraphicsScene*> scene)
     /**/
     beginResetModel();
     m_rootSection->load(json,scene);
+    m_idOf.clear();
+    m_typeOf.clear();
+    for(int i = 0; i < m_rootSection->getChildrenCount(); ++i)
+    {
+        connect(m_rootSection->getChildAt(i),SIGNAL(updateNeeded(CSItem*)),this,SLOT(updateItem(CSItem*)),Qt::UniqueConnection);
+    }
+    invalidateIndex();
+    rebuildPageIndex();
     endResetModel();
 }
 void FieldModel::removeItem(QModelIndex& index)
@@ -387,17 +811,21 @@ void FieldModel::removeItem(QModelIndex& index)
         {
             return;
         }
-        beginRemoveRows(index.parent(),
-                        parentSection->indexOfChild(childItem),
-                        parentSection->indexOfChild(childItem));
+        int row = rowOf(childItem);
+        beginRemoveRows(index.parent(),row,row);
 
+        unindexItem(childItem);
+        removeFromPageIndex(childItem);
+        emit fieldsRemoved(QList<CharacterSheetItem*>() << childItem);
+        emit definitionChanged();
         parentSection->deleteChild(childItem);
+        reindexRows(parentSection,row);
 
         endRemoveRows();
 
 
 
-    emit modelChanged();
+    notifyModelChanged();
     }
 }
 
@@ -424,24 +852,74 @@ void FieldModel::removeField(Field* field)
   {
     if(nullptr != parentSection)
     {
-      parent = parent.child(parentSection->indexOfChild(ancestor),0);
+      parent = parent.child(rowOf(ancestor),0);
     }
     parentSection = ancestor;
   }
 
-  beginRemoveRows(parent,
-                  parentSection->indexOfChild(field),
-                  parentSection->indexOfChild(field));
+  int row = rowOf(field);
+  beginRemoveRows(parent,row,row);
 
   parentSection->removeChild(field);
+  unindexItem(field);
+  reindexRows(parentSection,row);
+  removeFromPageIndex(field);
 
   endRemoveRows();
-  emit modelChanged();
+  emit fieldsRemoved(QList<CharacterSheetItem*>() << field);
+  emit definitionChanged();
+  notifyModelChanged();
+}
+void FieldModel::removeFields(const QList<CSItem*>& fields)
+{
+    QList<int> rows;
+    QList<CharacterSheetItem*> removed;
+    for(auto field : fields)
+    {
+        int row = field->getParent() == m_rootSection ? rowOf(field) : -1;
+        if(row >= 0)
+        {
+            rows.append(row);
+            removed.append(field);
+            unindexItem(field);
+            removeFromPageIndex(field);
+        }
+    }
+    if(rows.isEmpty())
+        return;
+
+    // from the last row so the rows of the next blocks stay valid
+    std::sort(rows.begin(),rows.end());
+    int last = rows.size()-1;
+    while(last >= 0)
+    {
+        int first = last;
+        while(first > 0 && rows[first-1] == rows[first]-1)
+            --first;
+
+        beginRemoveRows(QModelIndex(),rows[first],rows[last]);
+        for(int i = rows[last]; i >= rows[first]; --i)
+        {
+            m_rootSection->removeChild(m_rootSection->getChildAt(i));
+        }
+        // the rows must be right for the views reacting to endRemoveRows()
+        reindexRows(m_rootSection,rows[first]);
+        endRemoveRows();
+        last = first-1;
+    }
+    emit fieldsRemoved(removed);
+    emit definitionChanged();
+    notifyModelChanged();
 }
 void FieldModel::clearModel()
 {
     beginResetModel();
     m_rootSection->removeAll();
+    m_idOf.clear();
+    m_typeOf.clear();
+    m_pageIndex.clear();
+    m_pageOf.clear();
+    invalidateIndex();
     endResetModel();
 }
 
@@ -450,7 +928,9 @@ void FieldModel::setValueForAll(QModelIndex& index)
     if(index.isValid())
     {
         CharacterSheetItem* childItem = static_cast<CharacterSheetItem*>(index.internalPointer());
+        beginTransaction();
         m_rootSection->setValueForAll(childItem,m_colunm[index.column()]->getPos());
+        commitTransaction();
     }
 }
 
@@ -460,6 +940,19 @@ void FieldModel::resetAllId()
     int i = 0;
     m_rootSection->resetAllId(i);
     Field::setCount(i);
+    invalidateIndex();
     endResetModel();
+    // the live tree only: the index may still know sub-items freed by their table
+    std::function<void(CharacterSheetItem*)> check = [&](CharacterSheetItem* item){
+        checkRename(item);
+        for(int j = 0; j < item->getChildrenCount(); ++j)
+        {
+            check(item->getChildAt(j));
+        }
+    };
+    for(int j = 0; j < m_rootSection->getChildrenCount(); ++j)
+    {
+        check(m_rootSection->getChildAt(j));
+    }
 }
 
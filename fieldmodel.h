@@ -26,6 +26,8 @@
 #include <QObject>
 #include <QAbstractItemModel>
 #include <QTextStream>
+#include <QRect>
+#include <QSet>
 
 #include "field.h"
 //#include "charactersheetbutton.h"
@@ -134,6 +136,11 @@ public:
      * @param f
      */
     void appendField(CSItem* f);
+    /**
+     * @brief appendFields inserts all the fields at the end of the root section as one row range.
+     * @param fields
+     */
+    void appendFields(const QList<CSItem*>& fields);
     /**
      * @brief flags
      * @param index
@@ -156,8 +163,9 @@ public:
      * @brief generateQML
      * @param out
      * @param sec
+     * @param atlas regions of the packed images, by image key
      */
-    void generateQML(QTextStream& out, int indentation, bool isTable = false);
+    void generateQML(QTextStream& out, int indentation, bool isTable = false, const QHash<QString,QRect>& atlas = QHash<QString,QRect>());
     /**
     *
     */
@@ -168,9 +176,15 @@ public:
      */
     QList<CharacterSheetItem*> children();
     /**
-     * @brief removePageId
+     * @brief removePageId moves the fields of the pages after the removed one a page back.
+     * @param page removed page, its own fields are expected to be removed already.
+     */
+    void removePageId(int page);
+    /**
+     * @brief insertPageId moves the fields of the given page and the following ones a page forward.
+     * @param page inserted page
      */
-    void removePageId(int);
+    void insertPageId(int page);
     /**
      * @brief getRootSection
      * @return
@@ -187,6 +201,11 @@ public:
      */
     void removeItem(QModelIndex& index);
     void removeField(Field* field);
+    /**
+     * @brief removeFields removes top level fields, one row range per contiguous block.
+     * @param fields
+     */
+    void removeFields(const QList<CSItem*>& fields);
     /**
      * @brief setValueForAll
      * @param index
@@ -200,7 +219,7 @@ public:
      */
     void insertField(CSItem *field, CharacterSheetItem *parent, int pos);
     /**
-     * @brief getFieldFromPage
+     * @brief getFieldFromPage appends the top level fields of the page, in model order.
      * @param pagePos
      * @param list
      */
@@ -210,6 +229,40 @@ public:
      * @param index
      */
     Field* getFieldFromIndex(const QModelIndex& index);
+    /**
+     * @brief indexOf
+     * @param item top level item
+     * @return index of the first column, invalid when the item is not at the top level.
+     */
+    QModelIndex indexOf(CSItem* item) const;
+    /**
+     * @brief itemById finds an item, at any depth, from its id without walking the tree.
+     * @param id
+     * @return nullptr when no item has this id.
+     */
+    CharacterSheetItem* itemById(const QString& id) const;
+    /**
+     * @brief rowOf
+     * @param item
+     * @return row of the item in its parent, -1 when the item is not in the model.
+     */
+    int rowOf(const CharacterSheetItem* item) const;
+    /**
+     * @brief beginTransaction holds item updates and modelChanged() until the matching commitTransaction().
+     * Calls can be nested, updates are sent when the outermost transaction ends.
+     */
+    void beginTransaction();
+    /**
+     * @brief commitTransaction sends one dataChanged() per parent, covering the rows changed
+     * since beginTransaction(), then a single modelChanged().
+     */
+    void commitTransaction();
+    /**
+     * @brief propagateEdit publishes the structural delta of an edit made outside of setData().
+     * @param items edited items
+     * @param column edited property
+     */
+    void propagateEdit(const QList<CharacterSheetItem*>& items, CharacterSheetItem::ColumnId column);
 signals:
     /**
      * @brief valuesChanged
@@ -221,6 +274,20 @@ signals:
      * @brief modelChanged
      */
     void modelChanged();
+    /**
+     * Structural deltas: what the character sheets have to follow.
+     * Edits of the look or geometry of fields only send modelChanged().
+     */
+    void fieldsAdded(const QList<CharacterSheetItem*>& fields);
+    void fieldsRemoved(const QList<CharacterSheetItem*>& fields);
+    void fieldRenamed(CharacterSheetItem* field, const QString& oldId, const QString& newId);
+    void fieldRetyped(CharacterSheetItem* field, int oldType, int newType);
+    void fieldRedefined(CharacterSheetItem* field, CharacterSheetItem::ColumnId column);
+    /**
+     * @brief definitionChanged follows each of the deltas above, for the consumers
+     * which can only resync everything.
+     */
+    void definitionChanged();
 
 public slots:
     /**
@@ -233,7 +300,37 @@ private:
     QList<Column*> m_colunm;
     Section* m_rootSection;
     QStringList m_alignList;
+    void notifyModelChanged();
+    int m_transactionDepth = 0;
+    QSet<CSItem*> m_pendingItems;
+    bool m_pendingModelChanged = false;
+
+    // id -> item and item -> row, updated by every structural change, rebuilt after a reset
+    void invalidateIndex();
+    void ensureIndex() const;
+    void indexItem(CharacterSheetItem* item, int row) const;
+    void unindexItem(CharacterSheetItem* item);
+    void dropFromIndex(CharacterSheetItem* item);
+    void reindexRows(CharacterSheetItem* parent, int from);
+    void reindexChildren(CharacterSheetItem* item);
+    void checkRename(CharacterSheetItem* item);
+    void checkRetype(CharacterSheetItem* item);
+    mutable bool m_indexDirty = true;
+    mutable QHash<QString,CharacterSheetItem*> m_idIndex;
+    mutable QHash<const CharacterSheetItem*,int> m_rowIndex;
+    // children seen when the item was indexed, a table may free them behind our back
+    mutable QHash<const CharacterSheetItem*,QList<CharacterSheetItem*>> m_childrenOf;
+    // last id seen for each item, kept across rebuilds to detect renames
+    mutable QHash<CharacterSheetItem*,QString> m_idOf;
+    mutable QHash<CharacterSheetItem*,int> m_typeOf;
 
+    // page -> top level fields, kept up to date by every structural change
+    void addToPageIndex(CharacterSheetItem* item);
+    void removeFromPageIndex(CharacterSheetItem* item);
+    void checkPage(CharacterSheetItem* item);
+    void rebuildPageIndex();
+    QHash<int,QSet<CharacterSheetItem*>> m_pageIndex;
+    QHash<CharacterSheetItem*,int> m_pageOf;
 };
 
 #endif // FIELDMODEL_H
@@ -0,0 +1,117 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include "imageatlas.h"
+
+#include <QPainter>
+#include <algorithm>
+
+#include "imagestore.h"
+
+#define ATLAS_WIDTH 1024
+#define SMALL_IMAGE_SIZE 128
+#define ATLAS_PADDING 1
+
+ImageAtlas::ImageAtlas()
+{
+
+}
+
+bool ImageAtlas::build(ImageStore* store, const QStringList& keys)
+{
+    m_image = QImage();
+    m_regions.clear();
+    if(nullptr == store)
+        return false;
+
+    QList<QPair<QString,QImage>> images;
+    for(const auto& key : keys)
+    {
+        if(key == ImageAtlas::key() || !isSmall(store->size(key)))
+            continue;
+        auto img = store->image(key);
+        if(!img.isNull())
+            images.append(qMakePair(key,img));
+    }
+    // packing is worth it only when several loads are saved.
+    if(images.size() < 2)
+        return false;
+
+    // tallest first, then each shelf is filled from left to right.
+    std::sort(images.begin(),images.end(),[](const QPair<QString,QImage>& a, const QPair<QString,QImage>& b){
+        return a.second.height() > b.second.height();
+    });
+
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for(const auto& pair : images)
+    {
+        auto size = pair.second.size();
+        if(x + size.width() > ATLAS_WIDTH)
+        {
+            x = 0;
+            y += shelfHeight + ATLAS_PADDING;
+            shelfHeight = 0;
+        }
+        m_regions.insert(pair.first,QRect(QPoint(x,y),size));
+        x += size.width() + ATLAS_PADDING;
+        shelfHeight = qMax(shelfHeight,size.height());
+    }
+
+    int width = 0;
+    for(const auto& rect : m_regions)
+        width = qMax(width,rect.right()+1);
+
+    m_image = QImage(width,y+shelfHeight,QImage::Format_ARGB32_Premultiplied);
+    m_image.fill(Qt::transparent);
+    QPainter painter(&m_image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for(const auto& pair : images)
+        painter.drawImage(m_regions[pair.first].topLeft(),pair.second);
+    painter.end();
+    return true;
+}
+
+QImage ImageAtlas::image() const
+{
+    return m_image;
+}
+
+QHash<QString,QRect> ImageAtlas::regions() const
+{
+    return m_regions;
+}
+
+bool ImageAtlas::isEmpty() const
+{
+    return m_regions.isEmpty();
+}
+
+QString ImageAtlas::key()
+{
+    return QStringLiteral("atlas.png");
+}
+
+bool ImageAtlas::isSmall(const QSize& size)
+{
+    return size.isValid() && size.width() <= SMALL_IMAGE_SIZE && size.height() <= SMALL_IMAGE_SIZE;
+}
@@ -0,0 +1,55 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#ifndef IMAGEATLAS_H
+#define IMAGEATLAS_H
+
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QStringList>
+
+class ImageStore;
+/**
+ * @brief The ImageAtlas class packs small images of the sheet into a single image (shelf packing).
+ * The generated QML then shows regions of it with sourceClipRect: one image load and one texture
+ * for all of them.
+ */
+class ImageAtlas
+{
+public:
+    ImageAtlas();
+
+    bool build(ImageStore* store, const QStringList& keys);
+
+    QImage image() const;
+    QHash<QString,QRect> regions() const;
+    bool isEmpty() const;
+
+    static QString key();
+    static bool isSmall(const QSize& size);
+
+private:
+    QImage m_image;
+    QHash<QString,QRect> m_regions;
+};
+
+#endif // IMAGEATLAS_H
@@ -1,14 +1,19 @@
 #include "imagemodel.h"
+#include "imageatlas.h"
 #include <QIcon>
 #include <QBuffer>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <functional>
+#include <QColor>
 
-#define TOOLTIP_SIZE 256
+#define DUPLICATE_DISTANCE 10 // bits out of 64
 
-ImageModel::ImageModel(QHash<QString,QPixmap*>& list,QObject *parent)
+ImageModel::ImageModel(QObject *parent)
     : QAbstractTableModel(parent),
-      m_list(list)
+      m_store(new ImageStore())
 {
-    m_column << tr("Key")<< tr("Filename")<< tr("Is Background");
+    m_column << tr("Key")<< tr("Filename")<< tr("Is Background")<< tr("Encoding")<< tr("Quality");
 }
 
 QVariant ImageModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -28,7 +33,7 @@ int ImageModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
-    return  m_keyList.size();
+    return  m_keys.size();
 }
 
 int ImageModel::columnCount(const QModelIndex &parent) const
@@ -43,16 +48,21 @@ QVariant ImageModel::data(const QModelIndex &index, int role) const
     if (!index.isValid())
         return QVariant();
 
+    auto key = m_keys.at(index.row());
     if(Qt::DisplayRole == role)
     {
         switch (index.column())
         {
             case Key:
-                return "image://rcs/"+m_keyList.at(index.row());
+                return "image://rcs/"+key;
             case Filename:
-                return m_filename.at(index.row());
+                return m_store->imageData(key).m_filename;
             case Background:
-                return m_background.at(static_cast<size_t>(index.row()));
+                return m_store->imageData(key).m_isBackground;
+            case Encoding:
+                return static_cast<int>(m_store->imageData(key).m_encoding);
+            case Quality:
+                return m_store->imageData(key).m_quality;
         }
     }
     else if(Qt::EditRole == role)
@@ -60,22 +70,36 @@ QVariant ImageModel::data(const QModelIndex &index, int role) const
         switch (index.column())
         {
             case Key:
-                return m_keyList.at(index.row());
+                return key;
             case Filename:
-                return m_filename.at(index.row());
+                return m_store->imageData(key).m_filename;
             case Background:
-                return m_background.at(static_cast<size_t>(index.row()));
+                return m_store->imageData(key).m_isBackground;
+            case Encoding:
+                return static_cast<int>(m_store->imageData(key).m_encoding);
+            case Quality:
+                return m_store->imageData(key).m_quality;
         }
     }
     else if(Qt::ToolTipRole == role)
     {
-        auto key =  m_keyList.at(index.row());
-        auto image = m_list[key];
-        auto pixmap = image->scaledToWidth(TOOLTIP_SIZE);
-        QByteArray data;
-        QBuffer buffer(&data);
-        pixmap.save(&buffer, "PNG", 100);
-        return QString("<img src='data:image/png;base64, %0'>").arg(QString(data.toBase64()));
+        QString toolTip;
+        if(m_duplicateOf.contains(key))
+            toolTip = tr("Looks like %1").arg(m_duplicateOf[key])+"<br/>";
+        if(m_previews.contains(key))
+            toolTip += m_previews[key].m_toolTip;
+        if(!toolTip.isEmpty())
+            return toolTip;
+    }
+    else if(Qt::BackgroundRole == role)
+    {
+        if(m_duplicateOf.contains(key))
+            return QColor(255,200,120);
+    }
+    else if(Qt::DecorationRole == role && index.column() == Key)
+    {
+        if(m_previews.contains(key))
+            return m_previews[key].m_icon;
     }
     return QVariant();
 }
@@ -84,24 +108,29 @@ bool ImageModel::setData(const QModelIndex &index, const QVariant &value, int ro
     bool val = false;
     if((Qt::DisplayRole == role)||(Qt::EditRole == role))
     {
+        auto key = m_keys.at(index.row());
         switch (index.column())
         {
         case Key:
+            val = renameImage(key,value.toString());
+            break;
+        case Background:
+            m_store->setBackground(key,value.toBool());
+            val = true;
+            break;
+        case Encoding:
         {
-            auto formerKey = m_keyList.at(index.row());
-            m_provider->removeImg(formerKey);
-            QPixmap* pix = m_list.value(formerKey);
-            m_list.remove(formerKey);
-
-            m_keyList.replace(index.row(),value.toString());
-            m_provider->insertPix(value.toString(),*pix);
-            m_list.insert(value.toString(),pix);
-        }
+            auto image = m_store->imageData(key);
+            m_store->setEncoding(key,static_cast<ImageEncoding>(value.toInt()),image.m_quality);
             val = true;
+        }
             break;
-        case Background:
-            m_background[static_cast<size_t>(index.row())]= value.toBool();
+        case Quality:
+        {
+            auto image = m_store->imageData(key);
+            m_store->setEncoding(key,image.m_encoding,qBound(1,value.toInt(),100));
             val = true;
+        }
             break;
         default:
             break;
@@ -112,49 +141,172 @@ bool ImageModel::setData(const QModelIndex &index, const QVariant &value, int ro
 
 QJsonArray ImageModel::save()
 {
+    // encoding is the slow part, images are encoded in parallel and the result is kept until the policy changes.
+    auto store = m_store;
+    std::function<QByteArray(const QString&)> encode = [store](const QString& key){
+        return store->encoded(key);
+    };
+    auto encodedList = QtConcurrent::blockingMapped<QList<QByteArray>>(m_keys,encode);
+
     QJsonArray images;
-    int i = 0;
-    for(auto key : m_keyList)
+    for(int i = 0; i < m_keys.size(); ++i)
     {
-        auto pix = m_list[key];
-        bool bg = m_background[static_cast<size_t>(i)];
-        if(pix != nullptr)
-        {
-            QJsonObject oj;
-
-            QByteArray bytes;
-            QBuffer buffer(&bytes);
-            buffer.open(QIODevice::WriteOnly);
-            pix->save(&buffer, "PNG");
-            oj["bin"]=QString(buffer.data().toBase64());
-            oj["key"]=key;
-            oj["isBg"]=bg;
-            images.append(oj);
-        }
-        ++i;
+        auto image = m_store->imageData(m_keys.at(i));
+        auto const& bytes = encodedList.at(i);
+        if(bytes.isEmpty())
+            continue;
+
+        QJsonObject oj;
+        // merged images only share their bytes in memory, every entry keeps its own "bin"
+        // so the file stays readable by rolisteam.
+        oj["bin"]=QString(bytes.toBase64());
+        oj["key"]=image.m_key;
+        oj["isBg"]=image.m_isBackground;
+        oj["encoding"]=static_cast<int>(image.m_encoding);
+        oj["quality"]=image.m_quality;
+        if(m_saveThumbnails && !image.m_thumbnail.isEmpty())
+            oj["thumb"]=QString(image.m_thumbnail.toBase64());
+        images.append(oj);
+    }
+    // the atlas of the last QML generation is only written to the file, it is not an editable image.
+    if(m_store->contains(ImageAtlas::key()))
+    {
+        QJsonObject oj;
+        oj["bin"]=QString(m_store->encoded(ImageAtlas::key()).toBase64());
+        oj["key"]=ImageAtlas::key();
+        oj["isBg"]=false;
+        images.append(oj);
     }
     return images;
 }
 
+QByteArray ImageModel::toPng(const QPixmap& pix)
+{
+    QByteArray bytes;
+    if(!pix.isNull())
+    {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        pix.save(&buffer, "PNG");
+    }
+    return bytes;
+}
+
+bool ImageModel::insertImage(const QPixmap& pix, const QString& key, const QString& filename, bool isBg)
+{
+    if(m_store->contains(key))
+        return false;
+
+    return insertImage(toPng(pix),key,filename,isBg,pix);
+}
 
-bool ImageModel::insertImage(QPixmap * pix, QString key, QString stuff, bool isBg)
+bool ImageModel::insertImage(const QByteArray& data, const QString& key, const QString& filename, bool isBg, const QPixmap& decoded, const QByteArray& thumbnail)
 {
-    if(m_keyList.contains(key))
+    ImageData image;
+    image.m_key = key;
+    image.m_filename = filename;
+    image.m_isBackground = isBg;
+    image.m_data = data;
+    image.m_thumbnail = thumbnail;
+
+    auto decodedImage = decoded.toImage();
+    if(!m_store->insert(image,decodedImage))
         return false;
 
-    beginInsertRows(QModelIndex(),m_list.size(),m_list.size());
-    m_provider->insertPix(key,*pix);
-    m_list.insert(key,pix);
-    m_keyList.append(key);
-    m_filename.append(stuff);
-    m_background.push_back(isBg);
+    beginInsertRows(QModelIndex(),m_keys.size(),m_keys.size());
+    m_keys.append(key);
     endInsertRows();
+
+    buildThumbnail(key,decodedImage);
+    return true;
+}
+
+void ImageModel::buildThumbnail(const QString& key, const QImage& decoded)
+{
+    // scaling and encoding run in the thread pool, the store keeps the result.
+    auto store = m_store;
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher,&QFutureWatcher<bool>::finished,this,[this,watcher,key](){
+        if(watcher->result())
+            updatePreview(key);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run([store,key,decoded](){
+        return store->buildThumbnail(key,decoded);
+    }));
+}
+
+void ImageModel::updatePreview(const QString& key)
+{
+    auto row = m_keys.indexOf(key);
+    if(row < 0)
+        return;
+
+    auto image = m_store->imageData(key);
+    if(image.m_icon.isNull())
+        return;
+
+    Preview preview;
+    preview.m_icon = QPixmap::fromImage(image.m_icon);
+    preview.m_toolTip = QString("<img src='data:image/png;base64, %0'>").arg(QString(image.m_thumbnail.toBase64()));
+    m_previews.insert(key,preview);
+
+    auto first = index(row,Key);
+    emit dataChanged(first,index(row,m_column.size()-1),QVector<int>() << Qt::DecorationRole << Qt::ToolTipRole);
+    updateDuplicates();
+}
+
+void ImageModel::updateDuplicates()
+{
+    // few images per sheet, comparing every pair is cheap. The first inserted image is the reference.
+    QHash<QString,QString> duplicates;
+    QList<QPair<QString,quint64>> hashes;
+    for(const auto& key : m_keys)
+    {
+        auto image = m_store->imageData(key);
+        if(!image.m_hasHash)
+            continue;
+        for(const auto& previous : hashes)
+        {
+            // merged images share the same bytes, they are no longer duplicates.
+            if(image.m_data.constData() != m_store->imageData(previous.first).m_data.constData()
+               && ImageStore::hashDistance(image.m_hash,previous.second) <= DUPLICATE_DISTANCE)
+            {
+                duplicates.insert(key,previous.first);
+                break;
+            }
+        }
+        hashes.append(qMakePair(key,image.m_hash));
+    }
+    if(duplicates == m_duplicateOf)
+        return;
+
+    m_duplicateOf = duplicates;
+    if(!m_keys.isEmpty())
+        emit dataChanged(index(0,Key),index(m_keys.size()-1,m_column.size()-1),QVector<int>() << Qt::BackgroundRole << Qt::ToolTipRole);
+}
+
+QString ImageModel::duplicateOf(const QString& key) const
+{
+    return m_duplicateOf.value(key);
+}
+
+bool ImageModel::mergeImage(const QString& key, const QString& target)
+{
+    if(!m_store->alias(key,target))
+        return false;
+
+    if(m_previews.contains(target))
+        m_previews.insert(key,m_previews[target]);
+    updateDuplicates();
+    auto row = m_keys.indexOf(key);
+    emit dataChanged(index(row,Key),index(row,m_column.size()-1));
     return true;
 }
 
 Qt::ItemFlags ImageModel::flags(const QModelIndex &index) const
 {
-    if(index.column() == Key || index.column() == Background)
+    if(index.column() == Key || index.column() == Background || index.column() == Encoding || index.column() == Quality)
     {
         return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
     }
@@ -167,26 +319,16 @@ Qt::ItemFlags ImageModel::flags(const QModelIndex &index) const
 void ImageModel::clear()
 {
     beginResetModel();
-    m_provider->cleanData();
-    m_list.clear();
-    m_keyList.clear();
-    m_filename.clear();
+    m_store->clear();
+    m_keys.clear();
+    m_previews.clear();
+    m_duplicateOf.clear();
     endResetModel();
 }
 
-void ImageModel::setImageProvider(RolisteamImageProvider *img)
-{
-    m_provider = img;
-}
-
-void ImageModel::setPixList(QHash<QString, QPixmap*> &list)
-{
-    m_list = list;
-}
 bool ImageModel::isBackgroundById(QString id)
 {
-    int i = m_keyList.indexOf(id);
-    return m_background.at(static_cast<size_t>(i));
+    return m_store->imageData(id).m_isBackground;
 }
 
 void ImageModel::removeImageAt(const QModelIndex& index)
@@ -201,21 +343,158 @@ void ImageModel::removeImageAt(const QModelIndex& index)
 
 void ImageModel::removeImageByKey(const QString& key)
 {
-    auto index = m_keyList.indexOf(key);
+    auto index = m_keys.indexOf(key);
     removeImage(index);
 }
 
+bool ImageModel::renameImage(const QString& key, const QString& newKey)
+{
+    auto row = m_keys.indexOf(key);
+    if(row < 0 || !m_store->rename(key,newKey))
+        return false;
+
+    m_keys.replace(row,newKey);
+    if(m_previews.contains(key))
+        m_previews.insert(newKey,m_previews.take(key));
+    else
+        buildThumbnail(newKey);
+    updateDuplicates();
+    emit dataChanged(index(row,Key),index(row,m_column.size()-1));
+    return true;
+}
+
+bool ImageModel::replaceImage(const QString& key, const QByteArray& data, const QPixmap& decoded)
+{
+    auto row = m_keys.indexOf(key);
+    if(row < 0 || data.constData() == m_store->imageData(key).m_data.constData())
+        return false;
+
+    auto decodedImage = decoded.toImage();
+    if(!m_store->replace(key,data,decodedImage))
+        return false;
+
+    m_previews.remove(key);
+    buildThumbnail(key,decodedImage);
+    updateDuplicates();
+    emit dataChanged(index(row,Key),index(row,m_column.size()-1));
+    return true;
+}
+
 void ImageModel::removeImage(int i)
 {
-    if(i < 0 || m_keyList.size() <= i)
+    if(i < 0 || m_keys.size() <= i)
         return;
 
     beginRemoveRows(QModelIndex(), i,i);
-    auto key = m_keyList.at(i);
-    m_list.remove(key);
-    m_provider->removeImg(key);
-    m_filename.removeAt(i);
-    m_keyList.removeAt(i);
-    m_background.erase(m_background.begin() + i);
+    m_store->remove(m_keys.at(i));
+    m_previews.remove(m_keys.at(i));
+    m_keys.removeAt(i);
     endRemoveRows();
+    updateDuplicates();
+}
+
+QSharedPointer<ImageStore> ImageModel::store() const
+{
+    return m_store;
+}
+
+QPixmap ImageModel::pixmap(const QString& key) const
+{
+    return QPixmap::fromImage(m_store->image(key));
+}
+
+QSize ImageModel::imageSize(const QString& key) const
+{
+    return m_store->size(key);
+}
+
+QStringList ImageModel::backgroundKeys() const
+{
+    QStringList keys;
+    for(const auto& key : m_keys)
+    {
+        if(m_store->imageData(key).m_isBackground)
+            keys << key;
+    }
+    return keys;
+}
+
+int ImageModel::cacheBudget() const
+{
+    return m_store->cacheBudget();
+}
+
+void ImageModel::setCacheBudget(int megaBytes)
+{
+    m_store->setCacheBudget(megaBytes);
+}
+
+int ImageModel::cacheUsage() const
+{
+    return m_store->cacheUsage();
+}
+
+int ImageModel::cacheHits() const
+{
+    return m_store->cacheHits();
+}
+
+int ImageModel::cacheMisses() const
+{
+    return m_store->cacheMisses();
+}
+
+void ImageModel::resetCacheStatistics()
+{
+    m_store->resetCacheStatistics();
+}
+
+bool ImageModel::saveThumbnails() const
+{
+    return m_saveThumbnails;
+}
+
+void ImageModel::setSaveThumbnails(bool b)
+{
+    m_saveThumbnails = b;
+}
+
+void ImageModel::setEncoding(const QString& key, ImageEncoding encoding, int quality, const QByteArray& encoded)
+{
+    m_store->setEncoding(key,encoding,quality,encoded);
+    auto row = m_keys.indexOf(key);
+    if(row >= 0)
+        emit dataChanged(index(row,Encoding),index(row,Quality));
+}
+
+QHash<QString,QRect> ImageModel::updateAtlas()
+{
+    removeAtlas();
+    QStringList keys;
+    for(const auto& key : m_keys)
+    {
+        if(!m_store->imageData(key).m_isBackground)
+            keys << key;
+    }
+    ImageAtlas atlas;
+    if(!atlas.build(m_store.data(),keys))
+        return QHash<QString,QRect>();
+
+    // a generation artifact: in the store for the preview and save(), never a row of the model.
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    atlas.image().save(&buffer,"PNG");
+
+    ImageData image;
+    image.m_key = ImageAtlas::key();
+    image.m_filename = tr("Packed small images");
+    image.m_data = bytes;
+    m_store->insert(image,atlas.image());
+    return atlas.regions();
+}
+
+void ImageModel::removeAtlas()
+{
+    m_store->remove(ImageAtlas::key());
 }
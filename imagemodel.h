@@ -5,25 +5,17 @@
 #include <QPixmap>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QSharedPointer>
 
-#include "charactersheet/rolisteamimageprovider.h"
-/*
- * TODO use struct instead of several list
-struct ImageData
-{
-    QString m_url;
-    QString m_key;
-    bool m_isBackground;
-    QPixmap m_pixmap;
-};*/
+#include "imagestore.h"
 
 class ImageModel : public QAbstractTableModel
 {
     Q_OBJECT
 
 public:
-    enum Headers {Key,Filename,Background};
-    explicit ImageModel(QHash<QString,QPixmap*>& list,QObject *parent = nullptr);
+    enum Headers {Key,Filename,Background,Encoding,Quality};
+    explicit ImageModel(QObject *parent = nullptr);
 
     // Header:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -35,10 +27,9 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
 
-    QList<QPixmap>* imageData() const;
-    void setImageData(QList<QPixmap>* imageData);
-
-    bool insertImage(QPixmap*, QString, QString, bool isBg);
+    static QByteArray toPng(const QPixmap& pix);
+    bool insertImage(const QPixmap& pix, const QString& key, const QString& filename, bool isBg);
+    bool insertImage(const QByteArray& data, const QString& key, const QString& filename, bool isBg, const QPixmap& decoded = QPixmap(), const QByteArray& thumbnail = QByteArray());
     Qt::ItemFlags flags(const QModelIndex &index) const override;
 
     void clear();
@@ -47,23 +38,59 @@ public:
 
     void removeImageAt(const QModelIndex& index);
 
-    void setImageProvider(RolisteamImageProvider* img);
-    void setPixList(QHash<QString,QPixmap*>& list);
-
-
     bool isBackgroundById(QString id);
 
-    //QHash<>getPixHash() const;
     void removeImageByKey(const QString &key);
+    bool renameImage(const QString& key, const QString& newKey);
+    bool replaceImage(const QString& key, const QByteArray& data, const QPixmap& decoded = QPixmap());
+
+    QSharedPointer<ImageStore> store() const;
+
+    QPixmap pixmap(const QString& key) const;
+    QSize imageSize(const QString& key) const;
+    QStringList backgroundKeys() const;
+
+    int cacheBudget() const;
+    void setCacheBudget(int megaBytes);
+    int cacheUsage() const;
+    int cacheHits() const;
+    int cacheMisses() const;
+    void resetCacheStatistics();
+
+    bool saveThumbnails() const;
+    void setSaveThumbnails(bool b);
+
+    void setEncoding(const QString& key, ImageEncoding encoding, int quality, const QByteArray& encoded = QByteArray());
+
+    QHash<QString,QRect> updateAtlas();
+    void removeAtlas();
+
+    QString duplicateOf(const QString& key) const;
+    bool mergeImage(const QString& key, const QString& target);
+
+private slots:
+    void updatePreview(const QString& key);
+
 private:
     void removeImage(int i);
+    void buildThumbnail(const QString& key, const QImage& decoded = QImage());
+    void updateDuplicates();
+
 private:
-    QStringList m_keyList;
-    QStringList m_filename;
-    std::vector<bool> m_background;
+    /**
+     * @brief Preview is what the image list shows, built once when the thumbnail is ready.
+     */
+    struct Preview
+    {
+        QPixmap m_icon;
+        QString m_toolTip;
+    };
+    QStringList m_keys;
     QStringList m_column;
-    QHash<QString,QPixmap*>& m_list;
-    RolisteamImageProvider* m_provider;
+    QSharedPointer<ImageStore> m_store;
+    QHash<QString,Preview> m_previews;
+    QHash<QString,QString> m_duplicateOf;
+    bool m_saveThumbnails = false;
 };
 
 #endif // IMAGEMODEL_H
@@ -0,0 +1,522 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include "imagestore.h"
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QSet>
+#include <QtAlgorithms>
+
+#define DEFAULT_CACHE_BUDGET 256 // MB
+#define THUMBNAIL_SIZE 256
+#define ICON_SIZE 32
+#define MAX_MIP_LEVEL 8
+#define ANALYSIS_SIZE 256
+#define PALETTE_COLORS 256
+#define PHOTO_COLORS 1024
+#define HASH_SIZE 8
+
+namespace
+{
+int imageCost(const QImage& img)
+{
+    // cost is counted in KB so large budgets still fit into an int
+    return qMax(1, static_cast<int>(img.sizeInBytes()/1024));
+}
+bool fitsInPalette(const QImage& img)
+{
+    QImage argb = img.convertToFormat(QImage::Format_ARGB32);
+    QSet<QRgb> colors;
+    for(int y = 0; y < argb.height(); ++y)
+    {
+        auto line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+        for(int x = 0; x < argb.width(); ++x)
+        {
+            colors.insert(line[x]);
+            if(colors.size() > PALETTE_COLORS)
+                return false;
+        }
+    }
+    return true;
+}
+QString levelKey(const QString& key, int level)
+{
+    return QStringLiteral("%1#mip%2").arg(key).arg(level);
+}
+}
+
+ImageStore::ImageStore()
+{
+    setCacheBudget(DEFAULT_CACHE_BUDGET);
+}
+
+bool ImageStore::contains(const QString& key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_images.contains(key);
+}
+
+bool ImageStore::insert(const ImageData& data, const QImage& decoded)
+{
+    ImageData image = data;
+    if(!decoded.isNull())
+    {
+        image.m_size = decoded.size();
+    }
+    else if(!image.m_size.isValid())
+    {
+        QBuffer buffer(&image.m_data);
+        QImageReader reader(&buffer);
+        image.m_size = reader.size();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if(m_images.contains(image.m_key))
+        return false;
+
+    m_images.insert(image.m_key,image);
+    if(!decoded.isNull())
+        cacheImage(image.m_key,decoded);
+    return true;
+}
+
+void ImageStore::remove(const QString& key)
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.remove(key);
+    m_cache.remove(key);
+    removeLevels(key);
+}
+
+bool ImageStore::rename(const QString& formerKey, const QString& newKey)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_images.contains(formerKey) || m_images.contains(newKey))
+        return false;
+
+    auto image = m_images.take(formerKey);
+    image.m_key = newKey;
+    m_images.insert(newKey,image);
+
+    auto img = m_cache.take(formerKey);
+    if(nullptr != img)
+        m_cache.insert(newKey,img,imageCost(*img));
+    removeLevels(formerKey);
+    return true;
+}
+
+bool ImageStore::replace(const QString& key, const QByteArray& data, const QImage& decoded)
+{
+    QSize size = decoded.size();
+    if(decoded.isNull())
+    {
+        QByteArray bytes = data;
+        QBuffer buffer(&bytes);
+        QImageReader reader(&buffer);
+        size = reader.size();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.find(key);
+    if(it == m_images.end())
+        return false;
+
+    // new bytes, same entry: the name, the role and the encoding policy stay.
+    it->m_data = data;
+    it->m_size = size;
+    it->m_encoded.clear();
+    it->m_thumbnail.clear();
+    it->m_icon = QImage();
+    it->m_hash = 0;
+    it->m_hasHash = false;
+    m_cache.remove(key);
+    removeLevels(key);
+    if(!decoded.isNull())
+        cacheImage(key,decoded);
+    return true;
+}
+
+void ImageStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.clear();
+    m_cache.clear();
+}
+
+ImageData ImageStore::imageData(const QString& key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_images.value(key);
+}
+
+void ImageStore::setBackground(const QString& key, bool isBg)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.find(key);
+    if(it != m_images.end())
+        it->m_isBackground = isBg;
+}
+
+QImage ImageStore::image(const QString& key)
+{
+    QByteArray data;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto img = m_cache.object(key);
+        if(nullptr != img)
+        {
+            ++m_cacheHits;
+            return *img;
+        }
+        ++m_cacheMisses;
+        if(!m_images.contains(key))
+            return QImage();
+        data = m_images.value(key).m_data;
+    }
+
+    // decode without holding the lock, several threads may decode at once.
+    QImage decoded = QImage::fromData(data);
+    if(!decoded.isNull())
+    {
+        QMutexLocker locker(&m_mutex);
+        if(m_images.contains(key))
+            cacheImage(key,decoded);
+    }
+    return decoded;
+}
+
+QImage ImageStore::image(const QString& key, const QSize& requestedSize)
+{
+    QSize fullSize = size(key);
+    int level = mipLevel(fullSize,requestedSize);
+    if(level == 0)
+        return image(key);
+
+    QByteArray data;
+    QImage full;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto img = m_cache.object(levelKey(key,level));
+        if(nullptr != img)
+        {
+            ++m_cacheHits;
+            return *img;
+        }
+        ++m_cacheMisses;
+        if(!m_images.contains(key))
+            return QImage();
+        auto fullImg = m_cache.object(key);
+        if(nullptr != fullImg)
+            full = *fullImg;
+        else
+            data = m_images.value(key).m_data;
+    }
+
+    QSize levelSize(qMax(1,fullSize.width() >> level),qMax(1,fullSize.height() >> level));
+    QImage reduced;
+    if(!full.isNull())
+    {
+        reduced = full.scaled(levelSize,Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
+    }
+    else
+    {
+        // decode straight at the level size, the full image is never allocated.
+        QBuffer buffer(&data);
+        QImageReader reader(&buffer);
+        reader.setScaledSize(levelSize);
+        reduced = reader.read();
+    }
+
+    if(!reduced.isNull())
+    {
+        QMutexLocker locker(&m_mutex);
+        if(m_images.contains(key))
+            m_cache.insert(levelKey(key,level),new QImage(reduced),imageCost(reduced));
+    }
+    return reduced;
+}
+
+int ImageStore::mipLevel(const QSize& size, const QSize& requestedSize)
+{
+    // a zero dimension means "keep the aspect ratio" as in QML sourceSize.
+    if(!size.isValid() || (requestedSize.width() <= 0 && requestedSize.height() <= 0))
+        return 0;
+
+    int level = 0;
+    while(level < MAX_MIP_LEVEL)
+    {
+        int next = level + 1;
+        if(requestedSize.width() > 0 && (size.width() >> next) < requestedSize.width())
+            break;
+        if(requestedSize.height() > 0 && (size.height() >> next) < requestedSize.height())
+            break;
+        level = next;
+    }
+    return level;
+}
+
+QSize ImageStore::size(const QString& key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_images.value(key).m_size;
+}
+
+bool ImageStore::buildThumbnail(const QString& key, const QImage& decoded)
+{
+    QByteArray data;
+    QByteArray thumbnailData;
+    QSize size;
+    {
+        QMutexLocker locker(&m_mutex);
+        if(!m_images.contains(key))
+            return false;
+        const auto& image = m_images[key];
+        data = image.m_data;
+        thumbnailData = image.m_thumbnail;
+        size = image.m_size;
+    }
+
+    QImage thumbnail;
+    if(!thumbnailData.isEmpty())
+    {
+        thumbnail = QImage::fromData(thumbnailData);
+    }
+    else
+    {
+        if(!decoded.isNull())
+        {
+            thumbnail = decoded.scaledToWidth(qMin(THUMBNAIL_SIZE,decoded.width()),Qt::SmoothTransformation);
+        }
+        else if(!data.isEmpty())
+        {
+            // let the reader scale while decoding, jpeg does it almost for free.
+            QBuffer buffer(&data);
+            QImageReader reader(&buffer);
+            if(size.isValid() && size.width() > THUMBNAIL_SIZE)
+                reader.setScaledSize(size.scaled(THUMBNAIL_SIZE,size.height(),Qt::KeepAspectRatio));
+            thumbnail = reader.read();
+        }
+        if(thumbnail.isNull())
+            return false;
+
+        QBuffer buffer(&thumbnailData);
+        buffer.open(QIODevice::WriteOnly);
+        thumbnail.save(&buffer,"PNG");
+    }
+    QImage icon = thumbnail.scaledToHeight(qMin(ICON_SIZE,thumbnail.height()),Qt::SmoothTransformation);
+    quint64 hash = perceptualHash(thumbnail);
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.find(key);
+    if(it == m_images.end())
+        return false;
+    it->m_thumbnail = thumbnailData;
+    it->m_icon = icon;
+    it->m_hash = hash;
+    it->m_hasHash = true;
+    return true;
+}
+
+void ImageStore::setEncoding(const QString& key, ImageEncoding encoding, int quality, const QByteArray& encoded)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.find(key);
+    if(it == m_images.end())
+        return;
+    if(it->m_encoding == encoding && it->m_quality == quality && encoded.isEmpty())
+        return;
+    it->m_encoding = encoding;
+    it->m_quality = quality;
+    it->m_encoded = encoded;
+}
+
+QByteArray ImageStore::encoded(const QString& key)
+{
+    ImageData image = imageData(key);
+    if(!image.m_encoded.isEmpty() || image.m_data.isEmpty())
+        return image.m_encoded.isEmpty() ? image.m_data : image.m_encoded;
+
+    QImage img = this->image(key);
+    if(img.isNull())
+        return image.m_data;
+
+    auto encoding = image.m_encoding;
+    if(encoding == ImageEncoding::Auto)
+        encoding = analyse(img);
+    if(encoding == ImageEncoding::WebP && !QImageWriter::supportedImageFormats().contains("webp"))
+        encoding = ImageEncoding::Jpeg;
+
+    QByteArray result;
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+    switch(encoding)
+    {
+    case ImageEncoding::Jpeg:
+        img.convertToFormat(QImage::Format_RGB32).save(&buffer,"JPEG",image.m_quality);
+        break;
+    case ImageEncoding::WebP:
+        img.save(&buffer,"WEBP",image.m_quality);
+        break;
+    case ImageEncoding::PalettePng:
+        img.convertToFormat(QImage::Format_Indexed8,Qt::ThresholdDither|Qt::AvoidDither).save(&buffer,"PNG");
+        break;
+    default:
+        img.save(&buffer,"PNG");
+        break;
+    }
+
+    // in auto mode, the original bytes win when they are already smaller (e.g. a jpeg file).
+    if(result.isEmpty() || (image.m_encoding == ImageEncoding::Auto && image.m_data.size() <= result.size()))
+        result = image.m_data;
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.find(key);
+    if(it != m_images.end() && it->m_encoding == image.m_encoding && it->m_quality == image.m_quality)
+        it->m_encoded = result;
+    return result;
+}
+
+ImageEncoding ImageStore::analyse(const QImage& img)
+{
+    // nearest neighbour sampling keeps the real colours, smooth scaling would blend them.
+    QImage sample = img.width() > ANALYSIS_SIZE || img.height() > ANALYSIS_SIZE
+            ? img.scaled(ANALYSIS_SIZE,ANALYSIS_SIZE,Qt::KeepAspectRatio,Qt::FastTransformation) : img;
+    sample = sample.convertToFormat(QImage::Format_ARGB32);
+
+    bool hasAlpha = false;
+    QSet<QRgb> colors;
+    for(int y = 0; y < sample.height(); ++y)
+    {
+        auto line = reinterpret_cast<const QRgb*>(sample.constScanLine(y));
+        for(int x = 0; x < sample.width(); ++x)
+        {
+            if(qAlpha(line[x]) != 255)
+                hasAlpha = true;
+            if(colors.size() <= PHOTO_COLORS)
+                colors.insert(line[x]);
+        }
+    }
+
+    // the sample may miss colours, a palette is only used when the full image really fits in it.
+    if(colors.size() <= PALETTE_COLORS && fitsInPalette(img))
+        return ImageEncoding::PalettePng;
+    if(hasAlpha || colors.size() <= PHOTO_COLORS)
+        return ImageEncoding::Png;
+    return ImageEncoding::Jpeg;
+}
+
+bool ImageStore::alias(const QString& key, const QString& target)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.find(key);
+    if(key == target || it == m_images.end() || !m_images.contains(target))
+        return false;
+
+    // the key is kept so every reference to it still works, the bytes are shared with the target.
+    const auto& source = m_images[target];
+    it->m_data = source.m_data;
+    it->m_size = source.m_size;
+    it->m_thumbnail = source.m_thumbnail;
+    it->m_icon = source.m_icon;
+    it->m_encoding = source.m_encoding;
+    it->m_quality = source.m_quality;
+    it->m_encoded = source.m_encoded;
+    it->m_hash = source.m_hash;
+    it->m_hasHash = source.m_hasHash;
+    m_cache.remove(key);
+    removeLevels(key);
+    return true;
+}
+
+quint64 ImageStore::perceptualHash(const QImage& img)
+{
+    // dHash: one bit per horizontal gradient of a 9x8 grey version, robust to scale and compression.
+    QImage small = img.scaled(HASH_SIZE+1,HASH_SIZE,Qt::IgnoreAspectRatio,Qt::SmoothTransformation)
+            .convertToFormat(QImage::Format_RGB32);
+    quint64 hash = 0;
+    for(int y = 0; y < HASH_SIZE; ++y)
+    {
+        auto line = reinterpret_cast<const QRgb*>(small.constScanLine(y));
+        for(int x = 0; x < HASH_SIZE; ++x)
+        {
+            hash <<= 1;
+            if(qGray(line[x]) < qGray(line[x+1]))
+                hash |= 1;
+        }
+    }
+    return hash;
+}
+
+int ImageStore::hashDistance(quint64 a, quint64 b)
+{
+    return qPopulationCount(a ^ b);
+}
+
+void ImageStore::cacheImage(const QString& key, const QImage& img)
+{
+    m_cache.insert(key,new QImage(img),imageCost(img));
+}
+
+void ImageStore::removeLevels(const QString& key)
+{
+    for(int level = 1; level <= MAX_MIP_LEVEL; ++level)
+        m_cache.remove(levelKey(key,level));
+}
+
+int ImageStore::cacheBudget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost()/1024;
+}
+
+void ImageStore::setCacheBudget(int megaBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(qMax(1,megaBytes)*1024);
+}
+
+int ImageStore::cacheUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.totalCost()/1024;
+}
+
+int ImageStore::cacheHits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheHits;
+}
+
+int ImageStore::cacheMisses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheMisses;
+}
+
+void ImageStore::resetCacheStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
+}
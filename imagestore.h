@@ -0,0 +1,112 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+/**
+ * @brief ImageEncoding is the format used to write an image into the .rcs file.
+ */
+enum class ImageEncoding : int {Auto, Png, Jpeg, WebP, PalettePng};
+
+/**
+ * @brief ImageData stores one image of the sheet in its compressed form.
+ */
+struct ImageData
+{
+    QString m_key;
+    QString m_filename;
+    bool m_isBackground = false;
+    QByteArray m_data;
+    QSize m_size;
+    QByteArray m_thumbnail;
+    QImage m_icon;
+    ImageEncoding m_encoding = ImageEncoding::Auto;
+    int m_quality = 90;
+    QByteArray m_encoded; // m_data written with m_encoding, empty until needed
+    quint64 m_hash = 0; // perceptual hash (dHash) of the thumbnail
+    bool m_hasHash = false;
+};
+
+/**
+ * @brief The ImageStore class owns every image of the sheet. It is shared (QSharedPointer)
+ * between ImageModel, the canvases and the QML image provider so no one keeps its own copy.
+ * Decoded images are kept in a LRU cache bounded by a memory budget, together with
+ * reduced levels (each one half the size of the previous) served to smaller requests.
+ * All methods are thread safe, the QML provider reads from it outside the GUI thread.
+ */
+class ImageStore
+{
+public:
+    ImageStore();
+
+    bool contains(const QString& key) const;
+    bool insert(const ImageData& data, const QImage& decoded = QImage());
+    void remove(const QString& key);
+    bool rename(const QString& formerKey, const QString& newKey);
+    bool replace(const QString& key, const QByteArray& data, const QImage& decoded = QImage());
+    void clear();
+
+    ImageData imageData(const QString& key) const;
+    void setBackground(const QString& key, bool isBg);
+
+    QImage image(const QString& key);
+    QImage image(const QString& key, const QSize& requestedSize);
+    QSize size(const QString& key) const;
+    static int mipLevel(const QSize& size, const QSize& requestedSize);
+
+    bool buildThumbnail(const QString& key, const QImage& decoded = QImage());
+
+    void setEncoding(const QString& key, ImageEncoding encoding, int quality, const QByteArray& encoded = QByteArray());
+    QByteArray encoded(const QString& key);
+    static ImageEncoding analyse(const QImage& img);
+
+    bool alias(const QString& key, const QString& target);
+    static quint64 perceptualHash(const QImage& img);
+    static int hashDistance(quint64 a, quint64 b);
+
+    int cacheBudget() const;
+    void setCacheBudget(int megaBytes);
+    int cacheUsage() const;
+    int cacheHits() const;
+    int cacheMisses() const;
+    void resetCacheStatistics();
+
+private:
+    void cacheImage(const QString& key, const QImage& img);
+    void removeLevels(const QString& key);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString,ImageData> m_images;
+    QCache<QString,QImage> m_cache;
+    int m_cacheHits = 0;
+    int m_cacheMisses = 0;
+};
+
+#endif // IMAGESTORE_H
@@ -2,14 +2,21 @@
 
 
 #include <QMouseEvent>
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
+
+#define FRAME_REPORT_INTERVAL 250 // ms
 
 
 ItemEditor::ItemEditor(QWidget* parent)
     : QGraphicsView(parent)
 {
     setAcceptDrops(true);
-    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
     setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform );
+    // fields are rectangles, the scene index answers the rubber band without per item shape tests.
+    setRubberBandSelectionMode(Qt::IntersectsItemBoundingRect);
+    m_lastReport.start();
 }
 
 bool ItemEditor::handle() const
@@ -42,3 +49,51 @@ void ItemEditor::mousePressEvent(QMouseEvent *event)
         QGraphicsView::mousePressEvent(event);
     }
 }
+
+bool ItemEditor::openGL() const
+{
+    return m_openGL;
+}
+
+void ItemEditor::setOpenGL(bool openGL)
+{
+    if(m_openGL == openGL)
+        return;
+    m_openGL = openGL;
+
+    if(m_openGL)
+    {
+        auto widget = new QOpenGLWidget();
+        QSurfaceFormat format;
+        format.setSamples(4);
+        widget->setFormat(format);
+        setViewport(widget);
+        // a GL frame is always redrawn completely, no need to compute exposed regions.
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+        setOptimizationFlags(QGraphicsView::DontAdjustForAntialiasing);
+    }
+    else
+    {
+        // raster only repaints the exposed regions, items draw inside their bounding rect.
+        setViewport(new QWidget());
+        setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+        setOptimizationFlags(QGraphicsView::OptimizationFlags());
+    }
+    setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform );
+}
+
+void ItemEditor::paintEvent(QPaintEvent* event)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QGraphicsView::paintEvent(event);
+
+    // smoothed over several frames, reported a few times per second.
+    qreal elapsed = timer.nsecsElapsed()/1000000.0;
+    m_frameTime = m_frameTime > 0.0 ? m_frameTime*0.8 + elapsed*0.2 : elapsed;
+    if(m_lastReport.elapsed() > FRAME_REPORT_INTERVAL)
+    {
+        m_lastReport.restart();
+        emit frameTimeChanged(m_frameTime);
+    }
+}
@@ -2,6 +2,7 @@
 #define ITEMEDITOR_H
 
 #include <QGraphicsView>
+#include <QElapsedTimer>
 
 
 class ItemEditor : public QGraphicsView
@@ -13,14 +14,22 @@ public:
     bool handle() const;
     void setHandle(bool handle);
 
+    bool openGL() const;
+    void setOpenGL(bool openGL);
+
 protected:
     void mousePressEvent(QMouseEvent* event);
+    void paintEvent(QPaintEvent* event);
 
 signals:
     void openContextMenu(QPoint);
+    void frameTimeChanged(qreal ms);
 
 private:
     bool m_handle;
+    bool m_openGL = false;
+    qreal m_frameTime = 0.0;
+    QElapsedTimer m_lastReport;
 };
 
 #endif // ITEMEDITOR_H
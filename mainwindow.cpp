@@ -51,6 +51,8 @@
 #include <QQmlProperty>
 #include <QTimer>
 #include <QDockWidget>
+#include <QLabel>
+#include <QStatusBar>
 #include "common/widgets/logpanel.h"
 #include "common/controller/logcontroller.h"
 
@@ -63,8 +65,15 @@
 #include "aboutrcse.h"
 #include "preferencesdialog.h"
 #include "codeeditordialog.h"
+#include "duplicatedialog.h"
+#include "tablecanvasfield.h"
+#include "sheetimageprovider.h"
+#include "imageatlas.h"
 
 #include "delegate/pagedelegate.h"
+#include "delegate/encodingdelegate.h"
+#include "widgets/pagestrip.h"
+#include "widgets/minimap.h"
 
 //Undo
 #include "undo/setfieldproperties.h"
@@ -75,6 +84,12 @@
 #include "undo/deletecharactercommand.h"
 #include "undo/deletepagecommand.h"
 #include "undo/deletefieldcommand.h"
+#include "undo/setgeometrycommand.h"
+#include "undo/duplicatefieldscommand.h"
+
+#include <algorithm>
+
+#define GRID_SIZE 10
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -105,6 +120,20 @@ MainWindow::MainWindow(QWidget *parent) :
     addDockWidget(Qt::BottomDockWidgetArea,wid);
     auto showLogPanel = wid->toggleViewAction();
 
+    QDockWidget* pageDock = new QDockWidget(tr("Pages"),this);
+    pageDock->setObjectName(QStringLiteral("pagestrip"));
+    m_pageStrip = new PageStrip();
+    pageDock->setWidget(m_pageStrip);
+    addDockWidget(Qt::LeftDockWidgetArea,pageDock);
+    auto showPageStrip = pageDock->toggleViewAction();
+
+    QDockWidget* miniMapDock = new QDockWidget(tr("Minimap"),this);
+    miniMapDock->setObjectName(QStringLiteral("minimap"));
+    m_miniMap = new MiniMap();
+    miniMapDock->setWidget(m_miniMap);
+    addDockWidget(Qt::RightDockWidgetArea,miniMapDock);
+    auto showMiniMap = miniMapDock->toggleViewAction();
+
     m_additionnalCode = "";
     m_additionnalImport = "";
     m_fixedScaleSheet = 1.0;
@@ -123,6 +152,13 @@ MainWindow::MainWindow(QWidget *parent) :
     m_canvasList.append(canvas);
     m_model = new FieldModel();
     connect(m_model,SIGNAL(modelChanged()),this,SLOT(modelChanged()));
+    // CharacterSheetModel can only be re-rooted, so it follows the definitionChanged() fallback
+    // rather than the deltas: one full resync per burst, cosmetic and geometry edits do not trigger it.
+    m_characterSyncTimer.setSingleShot(true);
+    m_characterSyncTimer.setInterval(0);
+    connect(&m_characterSyncTimer,SIGNAL(timeout()),this,SLOT(syncCharacters()));
+    connect(m_model,SIGNAL(definitionChanged()),&m_characterSyncTimer,SLOT(start()));
+    connect(m_model,SIGNAL(modelReset()),&m_characterSyncTimer,SLOT(start()));
     ui->treeView->setFieldModel(m_model);
     ui->treeView->setCurrentPage(&m_currentPage);
     ui->treeView->setCanvasList(&m_canvasList);
@@ -147,13 +183,20 @@ MainWindow::MainWindow(QWidget *parent) :
     m_alignOnX = new QAction(tr("Align on X"),m_view);
     m_sameWidth= new QAction(tr("Same Width"),m_view);
     m_sameHeight = new QAction(tr("Same Height"),m_view);
-    m_dupplicate = new QAction(tr("Dupplicate"),m_view);
+    m_distributeH = new QAction(tr("Distribute Horizontally"),m_view);
+    m_distributeV = new QAction(tr("Distribute Vertically"),m_view);
+    m_snapToGrid = new QAction(tr("Snap to Grid"),m_view);
+    m_dupplicate = new QAction(tr("Duplicate into Grid..."),m_view);
 
     connect(m_fitInView,SIGNAL(triggered(bool)),this,SLOT(setFitInView()));
     connect(m_alignOnY,SIGNAL(triggered(bool)),this,SLOT(alignOn()));
     connect(m_alignOnX,SIGNAL(triggered(bool)),this,SLOT(alignOn()));
     connect(m_sameWidth,SIGNAL(triggered(bool)),this,SLOT(sameGeometry()));
     connect(m_sameHeight,SIGNAL(triggered(bool)),this,SLOT(sameGeometry()));
+    connect(m_distributeH,SIGNAL(triggered(bool)),this,SLOT(distribute()));
+    connect(m_distributeV,SIGNAL(triggered(bool)),this,SLOT(distribute()));
+    connect(m_snapToGrid,SIGNAL(triggered(bool)),this,SLOT(snapToGrid()));
+    connect(m_dupplicate,SIGNAL(triggered(bool)),this,SLOT(duplicateIntoGrid()));
 
     m_view->installEventFilter(this);
 
@@ -167,9 +210,14 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->m_showItemIcon,&QAction::triggered,[=](bool triggered)
     {
         CanvasField::setShowImageField(triggered);
-        QList<QRectF> list;
-        list << m_view->sceneRect();
-        m_view->updateScene(list);
+        // fields are cached pictures, they have to be redrawn one by one.
+        for(auto canvas : m_canvasList)
+        {
+            for(auto item : canvas->items())
+            {
+                item->update();
+            }
+        }
     });
 
     ////////////////////
@@ -185,6 +233,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
     ui->menuEdition->addSeparator();
     ui->menuEdition->addAction(showLogPanel);
+    ui->menuEdition->addAction(showPageStrip);
+    ui->menuEdition->addAction(showMiniMap);
 
     undo->setShortcut(QKeySequence::Undo);
     redo->setShortcut(QKeySequence::Redo);
@@ -193,6 +243,11 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(m_view, SIGNAL(openContextMenu(QPoint)),this, SLOT(menuRequestedFromView(QPoint)));
 
     m_view->setScene(canvas);
+    m_miniMap->setView(m_view);
+    connect(canvas,&Canvas::selectedFieldsChanged,ui->treeView,&FieldView::selectFields);
+    connect(ui->treeView,&FieldView::fieldsSelected,this,[this](const QList<Field*>& fields){
+        m_canvasList[m_currentPage]->selectFields(fields);
+    });
     ui->scrollArea->setWidget(m_view);
 
     ui->m_addCheckBoxAct->setData(Canvas::ADDCHECKBOX);
@@ -309,8 +364,6 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->m_resetIdAct,SIGNAL(triggered(bool)),m_model,SLOT(resetAllId()));
     connect(ui->m_preferencesAction,SIGNAL(triggered(bool)),this,SLOT(showPreferences()));
 
-    m_imgProvider = new RolisteamImageProvider();
-
     connect(canvas,SIGNAL(imageChanged()),this,SLOT(setImage()));
 
     m_addCharacter = new QAction(tr("Add character"),this);
@@ -367,14 +420,26 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->m_aboutRcseAct,SIGNAL(triggered(bool)),this,SLOT(aboutRcse()));
     connect(ui->m_onlineHelpAct, SIGNAL(triggered()), this, SLOT(helpOnLine()));
 
-    m_imageModel = new ImageModel(m_pixList);
+    m_imageModel = new ImageModel(this);
     canvas->setImageModel(m_imageModel);
     ui->m_imageList->setModel(m_imageModel);
 
+    m_pageStrip->setCanvasList(&m_canvasList);
+    m_pageStrip->setFieldModel(m_model);
+    m_pageStrip->setImageModel(m_imageModel);
+    connect(m_pageStrip,SIGNAL(pageSelected(int)),ui->m_selectPageCb,SLOT(setCurrentIndex(int)));
+    connect(ui->m_selectPageCb,SIGNAL(currentIndexChanged(int)),m_pageStrip,SLOT(setCurrentPage(int)));
+    connect(m_model,SIGNAL(modelChanged()),m_pageStrip,SLOT(scheduleRefresh()));
+    connect(&m_undoStack,SIGNAL(indexChanged(int)),m_pageStrip,SLOT(scheduleRefresh()));
+    connect(AddPageCommand::getPagesModel(),SIGNAL(modelReset()),m_pageStrip,SLOT(scheduleRefresh()));
+    connect(m_imageModel,SIGNAL(modelReset()),m_pageStrip,SLOT(scheduleRefresh()));
+
     ui->m_imageList->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->m_imageList,SIGNAL(customContextMenuRequested(QPoint)),this,SLOT(menuRequestedForImageModel(QPoint)));
 
-    m_imageModel->setImageProvider(m_imgProvider);
+    // the engine takes ownership of the provider, it reads from the image store shared with the model.
+    ui->m_quickview->engine()->addImageProvider(QLatin1String("rcs"),new SheetImageProvider(m_imageModel->store()));
+    ui->m_imageList->setItemDelegateForColumn(ImageModel::Encoding,new EncodingDelegate(ui->m_imageList));
     auto* view = ui->m_imageList->horizontalHeader();
     view->setSectionResizeMode(0,QHeaderView::Stretch);
 #ifndef Q_OS_OSX
@@ -398,6 +463,7 @@ MainWindow::MainWindow(QWidget *parent) :
     m_copyPath = new QAction(tr("Copy Path"),ui->m_imageList);
     m_copyPath->setShortcut(QKeySequence("CTRL+c"));
     m_replaceImage= new QAction(tr("Change Image"),ui->m_imageList);
+    m_mergeImage = new QAction(tr("Merge with the duplicated image"),ui->m_imageList);
 
     ui->m_imageList->addAction(m_copyPath);
     connect(m_copyPath,SIGNAL(triggered(bool)),this,SLOT(copyPath()));
@@ -406,6 +472,15 @@ MainWindow::MainWindow(QWidget *parent) :
 
     readSettings();
     m_logPanel->initSetting();
+    m_imageModel->setCacheBudget(m_preferences->value("ImageCacheBudget",256).toInt());
+    m_imageModel->setSaveThumbnails(m_preferences->value("SaveThumbnails",false).toBool());
+
+    m_frameTime = new QLabel(this);
+    statusBar()->addPermanentWidget(m_frameTime);
+    connect(m_view,&ItemEditor::frameTimeChanged,this,[=](qreal ms){
+        m_frameTime->setText(tr("%1: %2 ms/frame").arg(m_view->openGL() ? tr("OpenGL") : tr("Raster")).arg(ms,0,'f',1));
+    });
+    m_view->setOpenGL(m_preferences->value("OpenGLViewport",false).toBool());
 }
 MainWindow::~MainWindow()
 {
@@ -447,6 +522,8 @@ void MainWindow::clearData()
     canvas->setUndoStack(&m_undoStack);
     m_canvasList.append(canvas);
     m_view->setScene(canvas);
+    m_miniMap->setScene(canvas);
+    connect(canvas,&Canvas::selectedFieldsChanged,ui->treeView,&FieldView::selectFields);
 
     m_imageModel->clear();
 
@@ -530,12 +607,15 @@ bool MainWindow::mayBeSaved()
 }
 
 void MainWindow::modelChanged()
+{
+    setWindowModified(true);
+}
+void MainWindow::syncCharacters()
 {
     if((nullptr != m_characterModel)&&(nullptr!=m_model))
     {
         m_characterModel->setRootSection(m_model->getRootSection());
     }
-    setWindowModified(true);
 }
 bool MainWindow::wheelEventForView(QWheelEvent *event)
 {
@@ -577,9 +657,6 @@ void MainWindow::openPDF()
     if(nullptr!=m_pdf)
     {
         qreal res = m_pdf->getDpi();
-        m_imageModel->clear();
-        QString id = QUuid::createUuid().toString();
-        static int lastCanvas=m_canvasList.size()-1;
 
         QSize previous;
         if(m_pdf->hasResolution())
@@ -603,7 +680,7 @@ void MainWindow::openPDF()
                 QMessageBox::warning(this,tr("Error! Can not make image!"),tr("System has failed while making image of the pdf page."),QMessageBox::Ok);
                 return;
             }
-            QPixmap* pix = new QPixmap();
+            QPixmap pix;
             if(!m_pdf->hasResolution())
             {
                 m_pdf->setWidth(image.size().width());
@@ -612,18 +689,18 @@ void MainWindow::openPDF()
             if(!previous.isValid())
             {
                 previous = image.size();
-                *pix=QPixmap::fromImage(image);
+                pix=QPixmap::fromImage(image);
             }
             else if(previous != image.size())
             {
-                *pix=QPixmap::fromImage(image.scaled(previous.width(),previous.height(),Qt::KeepAspectRatio,Qt::SmoothTransformation));
+                pix=QPixmap::fromImage(image.scaled(previous.width(),previous.height(),Qt::KeepAspectRatio,Qt::SmoothTransformation));
             }
             else
             {
-                *pix=QPixmap::fromImage(image);
+                pix=QPixmap::fromImage(image);
             }
 
-            if(!pix->isNull())
+            if(!pix.isNull())
             {
                 if(i>=m_canvasList.size())
                 {
@@ -634,11 +711,9 @@ void MainWindow::openPDF()
                     Canvas* canvas = m_canvasList[i];
                     if(nullptr!=canvas)
                     {
-                        canvas->setPixmap(pix);
-                        SetBackgroundCommand* cmd = new SetBackgroundCommand(canvas,pix);
+                        // the canvas sends imageChanged, its page entry is then stored by setImage()
+                        SetBackgroundCommand* cmd = new SetBackgroundCommand(canvas,ImageModel::toPng(pix),pix);
                         m_undoStack.push(cmd);
-                        QString key = QStringLiteral("%2_background_%1.jpg").arg(lastCanvas+i).arg(id);
-                        m_imageModel->insertImage(pix,key,QString("From PDF"),true);
                     }
                 }
             }
@@ -676,22 +751,46 @@ void MainWindow::openImage()
         }
         else
         {
-            QPixmap* pix = new QPixmap(img);
-            if(!pix->isNull())
+            QFile file(img);
+            if(!file.open(QIODevice::ReadOnly))
+                return;
+            QByteArray bytes = file.readAll();
+            QPixmap pix;
+            pix.loadFromData(bytes);
+            if(!pix.isNull())
             {
                 Canvas* canvas = m_canvasList[m_currentPage];
-                canvas->setPixmap(pix);
-                SetBackgroundCommand* cmd = new SetBackgroundCommand(canvas,pix);
+                SetBackgroundCommand* cmd = new SetBackgroundCommand(canvas,bytes,pix);
                 m_undoStack.push(cmd);
-                QString id = QUuid::createUuid().toString();
-                QString key = QStringLiteral("%2_background_%1.jpg").arg(m_currentPage).arg(id);
-                m_imageModel->insertImage(pix,key,img,true);
             }
         }
     }
 
 }
 
+QList<CanvasField*> MainWindow::selectedFields() const
+{
+    QList<CanvasField*> fields;
+    for(auto item : m_view->scene()->selectedItems())
+    {
+        auto field = dynamic_cast<CanvasField*>(item);
+        if(nullptr != field)
+            fields.append(field);
+    }
+    return fields;
+}
+
+void MainWindow::applyGeometries(const QList<CanvasField*>& fields, const QList<QRectF>& geometries, const QString& text)
+{
+    bool changed = false;
+    for(int i = 0; i < fields.size() && !changed; ++i)
+    {
+        changed = SetGeometryCommand::geometry(fields[i]) != geometries[i];
+    }
+    if(changed)
+        m_undoStack.push(new SetGeometryCommand(m_model,fields,geometries,text));
+}
+
 void MainWindow::sameGeometry()
 {
     auto action = qobject_cast<QAction*>(sender());
@@ -700,8 +799,7 @@ void MainWindow::sameGeometry()
     {
         width = true;
     }
-    QList<QGraphicsItem*> items = m_view->scene()->selectedItems();
-    QGraphicsItem* reference = m_view->itemAt(m_posMenu);
+    auto reference = dynamic_cast<CanvasField*>(m_view->itemAt(m_posMenu));
     if(nullptr != reference)
     {
         qreal value = reference->boundingRect().height();
@@ -710,19 +808,22 @@ void MainWindow::sameGeometry()
             value = reference->boundingRect().width();
         }
 
-
-        for(auto item : items)
+        auto fields = selectedFields();
+        QList<QRectF> geometries;
+        for(auto field : fields)
         {
-            auto field = dynamic_cast<CanvasField*>(item);
+            QRectF rect = SetGeometryCommand::geometry(field);
             if(width)
             {
-                field->setWidth(value);
+                rect.setWidth(value);
             }
             else
             {
-                field->setHeight(value);
+                rect.setHeight(value);
             }
+            geometries.append(rect);
         }
+        applyGeometries(fields,geometries,width ? tr("Same Width") : tr("Same Height"));
     }
 }
 
@@ -735,8 +836,7 @@ void MainWindow::alignOn()
         onX = true;
     }
 
-    QList<QGraphicsItem*> items = m_view->scene()->selectedItems();
-    QGraphicsItem* reference = m_view->itemAt(m_posMenu);
+    auto reference = dynamic_cast<CanvasField*>(m_view->itemAt(m_posMenu));
     if(nullptr != reference)
     {
         qreal value = reference->pos().y();
@@ -745,20 +845,107 @@ void MainWindow::alignOn()
             value = reference->pos().x();
         }
 
-
-        for(auto item : items)
+        auto fields = selectedFields();
+        QList<QRectF> geometries;
+        for(auto field : fields)
         {
+            QRectF rect = SetGeometryCommand::geometry(field);
             if(onX)
             {
-                item->setPos(value,item->pos().y());
+                rect.moveLeft(value);
             }
             else
             {
-                item->setPos(item->pos().x(),value);
-
+                rect.moveTop(value);
             }
+            geometries.append(rect);
+        }
+        applyGeometries(fields,geometries,onX ? tr("Align on X") : tr("Align on Y"));
+    }
+}
+
+void MainWindow::distribute()
+{
+    auto action = qobject_cast<QAction*>(sender());
+    bool horizontal = (m_distributeH == action);
+
+    auto fields = selectedFields();
+    if(fields.size() < 3)
+        return;
+
+    // the first and last fields stay, the others are spread with equal gaps between them.
+    std::sort(fields.begin(),fields.end(),[horizontal](CanvasField* a, CanvasField* b){
+        return horizontal ? a->pos().x() < b->pos().x() : a->pos().y() < b->pos().y();
+    });
+    QList<QRectF> geometries;
+    qreal total = 0;
+    for(auto field : fields)
+    {
+        QRectF rect = SetGeometryCommand::geometry(field);
+        total += horizontal ? rect.width() : rect.height();
+        geometries.append(rect);
+    }
+    qreal start = horizontal ? geometries.first().left() : geometries.first().top();
+    qreal end = horizontal ? geometries.last().right() : geometries.last().bottom();
+    qreal gap = (end - start - total)/(fields.size()-1);
+
+    qreal cursor = start;
+    for(auto& rect : geometries)
+    {
+        if(horizontal)
+        {
+            rect.moveLeft(cursor);
+            cursor += rect.width() + gap;
         }
+        else
+        {
+            rect.moveTop(cursor);
+            cursor += rect.height() + gap;
+        }
+    }
+    applyGeometries(fields,geometries,horizontal ? tr("Distribute Horizontally") : tr("Distribute Vertically"));
+}
+
+void MainWindow::snapToGrid()
+{
+    auto fields = selectedFields();
+    QList<QRectF> geometries;
+    for(auto field : fields)
+    {
+        QRectF rect = SetGeometryCommand::geometry(field);
+        QPointF topLeft(qRound(rect.left()/GRID_SIZE)*GRID_SIZE,qRound(rect.top()/GRID_SIZE)*GRID_SIZE);
+        QPointF bottomRight(qRound(rect.right()/GRID_SIZE)*GRID_SIZE,qRound(rect.bottom()/GRID_SIZE)*GRID_SIZE);
+        if(bottomRight.x() <= topLeft.x())
+            bottomRight.setX(topLeft.x()+GRID_SIZE);
+        if(bottomRight.y() <= topLeft.y())
+            bottomRight.setY(topLeft.y()+GRID_SIZE);
+        geometries.append(QRectF(topLeft,bottomRight));
     }
+    applyGeometries(fields,geometries,tr("Snap to Grid"));
+}
+
+void MainWindow::duplicateIntoGrid()
+{
+    QList<Field*> sources;
+    for(auto field : selectedFields())
+    {
+        // tables own sub fields and a dedicated item, they are not copied here.
+        if(nullptr != field->getField() && nullptr == dynamic_cast<TableCanvasField*>(field))
+            sources.append(field->getField());
+    }
+    if(sources.isEmpty())
+        return;
+
+    DuplicateDialog dialog(this);
+    if(QDialog::Accepted != dialog.exec())
+        return;
+    if(dialog.rows()*dialog.columns() < 2)
+        return;
+
+    auto canvas = m_canvasList[m_currentPage];
+    m_undoStack.push(new DuplicateFieldsCommand(canvas,m_model,sources,dialog.rows(),dialog.columns(),
+                                                dialog.horizontalSpacing(),dialog.verticalSpacing()));
+    setWindowModified(true);
 }
 
 void MainWindow::setFitInView()
@@ -766,10 +953,9 @@ void MainWindow::setFitInView()
     if(m_fitInView->isChecked())
     {
         Canvas* canvas = m_canvasList[m_currentPage];
-        QPixmap* pix = canvas->pixmap();
-        if(nullptr != pix)
+        if(canvas->hasBackground())
         {
-            m_view->fitInView(QRectF(pix->rect()),Qt::KeepAspectRatioByExpanding);
+            m_view->fitInView(QRectF(QPointF(0,0),canvas->backgroundSize()),Qt::KeepAspectRatioByExpanding);
         }
     }
     else
@@ -784,10 +970,25 @@ void MainWindow::showPreferences()
     {
         dialog.setGenerationPath(m_preferences->value("GenerationCustomPath",QDir::homePath()).toString());
     }
+    dialog.setImageCacheBudget(m_preferences->value("ImageCacheBudget",256).toInt());
+    dialog.setPageMemoryBudget(m_preferences->value("PageMemoryBudget",256).toInt());
+    dialog.setImageCacheStatistics(m_imageModel->cacheHits(),m_imageModel->cacheMisses(),m_imageModel->cacheUsage());
+    dialog.setSaveThumbnails(m_preferences->value("SaveThumbnails",false).toBool());
+    dialog.setPackSmallImages(m_preferences->value("PackSmallImages",false).toBool());
+    dialog.setOpenGLViewport(m_preferences->value("OpenGLViewport",false).toBool());
     if(QDialog::Accepted == dialog.exec())
     {
         m_preferences->registerValue("hasCustomPath",dialog.hasCustomPath());
         m_preferences->registerValue("GenerationCustomPath",dialog.generationPath());
+        m_preferences->registerValue("ImageCacheBudget",dialog.imageCacheBudget());
+        m_imageModel->setCacheBudget(dialog.imageCacheBudget());
+        m_preferences->registerValue("PageMemoryBudget",dialog.pageMemoryBudget());
+        releaseUnusedPages();
+        m_preferences->registerValue("SaveThumbnails",dialog.saveThumbnails());
+        m_imageModel->setSaveThumbnails(dialog.saveThumbnails());
+        m_preferences->registerValue("PackSmallImages",dialog.packSmallImages());
+        m_preferences->registerValue("OpenGLViewport",dialog.openGLViewport());
+        m_view->setOpenGL(dialog.openGLViewport());
     }
 }
 
@@ -814,6 +1015,9 @@ void MainWindow::menuRequestedFromView(const QPoint & pos)
     menu.addAction(m_alignOnY);
     menu.addAction(m_sameWidth);
     menu.addAction(m_sameHeight);
+    menu.addAction(m_distributeH);
+    menu.addAction(m_distributeV);
+    menu.addAction(m_snapToGrid);
     menu.addSeparator();
     menu.addAction(m_dupplicate);
 
@@ -916,9 +1120,11 @@ void MainWindow::menuRequestedForImageModel(const QPoint & pos)
         menu.addAction(m_copyPath);
         menu.addSeparator();
         menu.addAction(m_replaceImage);
+        menu.addAction(m_mergeImage);
         menu.addAction(ui->m_deleteImageAct);
 
         m_copyPath->setEnabled(index.column()==1);
+        m_mergeImage->setEnabled(!m_imageModel->duplicateOf(index.sibling(index.row(),ImageModel::Key).data(Qt::EditRole).toString()).isEmpty());
     }
 
     QAction* act = menu.exec(QCursor::pos());
@@ -926,6 +1132,11 @@ void MainWindow::menuRequestedForImageModel(const QPoint & pos)
     if( m_replaceImage == act)
     {
     }
+    else if(m_mergeImage == act)
+    {
+        auto key = index.sibling(index.row(),ImageModel::Key).data(Qt::EditRole).toString();
+        mergeImage(key,m_imageModel->duplicateOf(key));
+    }
 
 }
 void MainWindow::copyPath()
@@ -939,6 +1150,33 @@ void MainWindow::copyPath()
     }
 }
 
+void MainWindow::mergeImage(const QString& key, const QString& target)
+{
+    if(key.isEmpty() || target.isEmpty())
+        return;
+
+    QRegularExpression exp(".*_background_(\\d+).*");
+    QRegularExpressionMatch match = exp.match(key);
+    if(!m_imageModel->isBackgroundById(key) || !match.hasMatch())
+    {
+        m_imageModel->mergeImage(key,target);
+        return;
+    }
+
+    // a background belongs to its page: the page takes the target picture too.
+    int page = match.captured(1).toInt();
+    if(page < 0 || page >= m_canvasList.size())
+        return;
+
+    // the image model decodes the target even when its page has released its background.
+    QPixmap pix = m_imageModel->pixmap(target);
+    if(pix.isNull() || !m_imageModel->mergeImage(key,target))
+        return;
+    // the canvas holds the target's bytes themselves, so setImage() finds them already stored under the key.
+    auto bytes = m_imageModel->store()->imageData(target).m_data;
+    m_undoStack.push(new SetBackgroundCommand(m_canvasList[page],bytes,pix));
+}
+
 void MainWindow::columnAdded()
 {
     int col = m_characterModel->columnCount();
@@ -947,33 +1185,35 @@ void MainWindow::columnAdded()
 
 void MainWindow::setImage()
 {
-    int i = 0;
-    m_imageModel->clear();
-    QString id = QUuid::createUuid().toString();//one id for all images.
+    // only the page which sent imageChanged() is updated, the other entries keep their key and policy.
+    auto sender = qobject_cast<Canvas*>(this->sender());
+    if(nullptr != sender)
+    {
+        updateBackground(sender);
+    }
+    else
+    {
+        for(auto canvas : m_canvasList)
+        {
+            updateBackground(canvas);
+        }
+    }
+
     QSize previous;
     bool issue = false;
     for(auto canvas : m_canvasList)
     {
-        QPixmap* pix = canvas->pixmap();
-        if(pix!=nullptr)
+        if(!canvas->hasBackground())
+            continue;
+        if(!previous.isValid())
         {
-            if(!previous.isValid())
-            {
-                previous = pix->size();
-            }
-            if(previous!=pix->size())
-            {
-                issue = true;
-            }
+            previous = canvas->backgroundSize();
             setFitInView();
         }
-        else if(nullptr == pix)
+        if(previous!=canvas->backgroundSize())
         {
-            pix=new QPixmap();
+            issue = true;
         }
-        QString idList = QStringLiteral("%2_background_%1.jpg").arg(i).arg(id);
-        m_imageModel->insertImage(pix,idList,"from canvas",true);
-        ++i;
     }
     if(issue)
     {
@@ -981,6 +1221,51 @@ void MainWindow::setImage()
     }
 }
 
+QString MainWindow::backgroundId() const
+{
+    // one id for all backgrounds, the generated QML builds their keys from it.
+    for(const auto& key : m_imageModel->backgroundKeys())
+    {
+        auto parts = key.split('_');
+        if(parts.size() > 1)
+            return parts.first();
+    }
+    return QUuid::createUuid().toString();
+}
+
+void MainWindow::updateBackground(Canvas* canvas)
+{
+    int page = m_canvasList.indexOf(canvas);
+    if(page < 0)
+        return;
+
+    QString key = canvas->backgroundKey();
+    bool stored = !key.isEmpty() && m_imageModel->store()->contains(key);
+    if(!canvas->hasBackground())
+    {
+        if(stored)
+            m_imageModel->removeImageByKey(key);
+        canvas->setBackgroundKey(QString());
+        return;
+    }
+
+    QString pageKey = QStringLiteral("%2_background_%1.jpg").arg(page).arg(backgroundId());
+    if(!stored)
+    {
+        m_imageModel->insertImage(canvas->backgroundData(),pageKey,"from canvas",true,canvas->background());
+        canvas->setBackgroundKey(pageKey);
+        return;
+    }
+    // the page moved since its background was stored
+    if(key != pageKey && m_imageModel->renameImage(key,pageKey))
+    {
+        key = pageKey;
+        canvas->setBackgroundKey(key);
+    }
+    // nothing is done when the bytes are already the stored ones
+    m_imageModel->replaceImage(key,canvas->backgroundData(),canvas->background());
+}
+
 void MainWindow::setCurrentTool()
 {
     QAction* action = dynamic_cast<QAction*>(sender());
@@ -1135,41 +1420,62 @@ void MainWindow::open()
                         return bObj["key"].toString() > aObj["key"].toString();
                     }
                 });
+                // merged images are saved with identical bytes, they are decoded once and shared.
+                QHash<QByteArray,QPixmap> pixByData;
                 int i = 0;
                 for(auto jsonpix : objList)
                 {
 
                     QJsonObject oj = jsonpix;//jsonpix.toObject();
-                    QString str = oj["bin"].toString();
                     QString id = oj["key"].toString();
                     bool isBg = oj["isBg"].toBool();
-                    QByteArray array = QByteArray::fromBase64(str.toUtf8());
-                    QPixmap* pix = new QPixmap();
-                    pix->loadFromData(array);
+                    // rebuilt by the next QML generation
+                    if(!isBg && id == ImageAtlas::key())
+                        continue;
+                    QByteArray array = QByteArray::fromBase64(oj["bin"].toString().toUtf8());
+                    QByteArray thumbnail = QByteArray::fromBase64(oj["thumb"].toString().toUtf8());
+                    QPixmap pix;
+                    // backgrounds of the other pages are decoded when the page is first shown.
+                    bool deferred = isBg && i != 0;
+                    auto known = pixByData.constFind(array);
+                    if(known != pixByData.constEnd())
+                    {
+                        // shares the bytes too, a duplicate costs no memory
+                        array = known.key();
+                        pix = known.value();
+                    }
+                    else if(!deferred)
+                    {
+                        pix.loadFromData(array);
+                        pixByData.insert(array,pix);
+                    }
+                    m_imageModel->insertImage(array,id,"from rcs file",isBg,pix,thumbnail);
+                    if(oj.contains("encoding"))
+                    {
+                        // the bytes are already written with this policy, keep them as they are.
+                        m_imageModel->setEncoding(id,static_cast<ImageEncoding>(oj["encoding"].toInt()),oj["quality"].toInt(90),array);
+                    }
                     if(isBg)
                     {
+                        Canvas* canvas = m_canvasList[0];
                         if(i!=0)
                         {
-                            Canvas* canvas = new Canvas();
+                            canvas = new Canvas();
                             canvas->setModel(m_model);
                             canvas->setImageModel(m_imageModel);
                             canvas->setUndoStack(&m_undoStack);
-                            SetBackgroundCommand cmd(canvas,pix);
-                            cmd.redo();
-                            canvas->setPixmap(pix);
                             canvas->setCurrentPage(i);
                             m_canvasList.append(canvas);
-                            connect(canvas,SIGNAL(imageChanged()),this,SLOT(setImage()));
-                        }
-                        else
-                        {
-                            m_canvasList[0]->setPixmap(pix);
-                            SetBackgroundCommand cmd(m_canvasList[0],pix);
-                            cmd.redo();
                         }
+                        // the entry is stored already, setImage() finds the same bytes under this key.
+                        canvas->setBackgroundKey(id);
+                        // a canvas out of sight keeps the bytes until its page is shown.
+                        SetBackgroundCommand cmd(canvas,array,pix);
+                        cmd.redo();
+                        if(i!=0)
+                            connect(canvas,SIGNAL(imageChanged()),this,SLOT(setImage()));
                         ++i;
                     }
-                    m_imageModel->insertImage(pix,id,"from rcs file",isBg);
                 }
                 QList<QGraphicsScene*> list;
                 for(auto canvas : m_canvasList)
@@ -1177,9 +1483,15 @@ void MainWindow::open()
                     list << canvas;
                 }
                 m_model->load(data,list);
+                // the items of the other pages enter their scene when the page is first shown
+                for(int i = 1; i < m_canvasList.size(); ++i)
+                {
+                    m_canvasList[i]->releaseFields();
+                }
                 m_characterModel->setRootSection(m_model->getRootSection());
                 m_characterModel->readModel(jsonObj,false);
                 updatePageSelector();
+                releaseUnusedPages();
                 setWindowTitle(m_title.arg(QFileInfo(m_filename).fileName()).arg("RCSE"));
                 setWindowModified(false);
             }
@@ -1216,7 +1528,51 @@ void MainWindow::currentPageChanged(int i)
     if((i>=0)&&(i<m_canvasList.size()))
     {
         m_currentPage = i;
+        m_canvasList[i]->restoreFields();
+        m_canvasList[i]->restoreBackground();
         m_view->setScene(m_canvasList[i]);
+        m_miniMap->setScene(m_canvasList[i]);
+        connect(m_canvasList[i],&Canvas::selectedFieldsChanged,ui->treeView,&FieldView::selectFields,Qt::UniqueConnection);
+        releaseUnusedPages();
+    }
+}
+void MainWindow::releaseUnusedPages()
+{
+    Canvas* current = m_canvasList.value(m_currentPage);
+    m_pageUsage.removeAll(current);
+    m_pageUsage.prepend(current);
+
+    // pages never shown are released first, then the least recently shown ones.
+    QList<Canvas*> candidates;
+    qint64 usage = 0;
+    for(auto canvas : m_canvasList)
+    {
+        usage += canvas->memoryCost();
+        if(!m_pageUsage.contains(canvas))
+            candidates.append(canvas);
+    }
+    for(int i = m_pageUsage.size()-1; i > 0; --i)
+    {
+        if(m_canvasList.contains(m_pageUsage[i]))
+            candidates.append(m_pageUsage[i]);
+        else
+            m_pageUsage.removeAt(i);
+    }
+
+    qint64 budget = static_cast<qint64>(m_preferences->value("PageMemoryBudget",256).toInt())*1024*1024;
+    if(usage <= budget)
+        return;
+
+    for(auto canvas : candidates)
+    {
+        if(usage <= budget)
+            break;
+        qint64 cost = canvas->memoryCost();
+        if(cost == 0)
+            continue;
+        canvas->releaseBackground();
+        canvas->releaseFields();
+        usage -= cost;
     }
 }
 void MainWindow::codeChanged()
@@ -1232,46 +1588,47 @@ void MainWindow::generateQML(QString& qml)
 {
 
     QTextStream text(&qml);
-    QPixmap* pix = nullptr;
     bool allTheSame=true;
     QSize size;
+    QString key;
 
-    QList<QPixmap*> imageList;
-    for(auto key : m_pixList.keys())
+    for(const auto& bgKey : m_imageModel->backgroundKeys())
     {
-        if(m_imageModel->isBackgroundById(key))
-        {
-            imageList.append(m_pixList.value(key));
-        }
-    }
-
-    for(QPixmap* pix2 : imageList)
-    {
-        if(size != pix2->size())
+        auto bgSize = m_imageModel->imageSize(bgKey);
+        if(size != bgSize)
         {
             if(size.isValid())
                 allTheSame=false;
-            size = pix2->size();
+            size = bgSize;
         }
-        pix = pix2;
+        key = bgKey;
     }
     qreal ratio = 1;
     qreal ratioBis= 1;
     bool hasImage= false;
-    if((allTheSame)&&(nullptr!=pix)&&(!pix->isNull()))
+    if((allTheSame)&&(!size.isEmpty()))
     {
-        ratio = static_cast<qreal>(pix->width())/static_cast<qreal>(pix->height());
-        ratioBis = static_cast<qreal>(pix->height())/static_cast<qreal>(pix->width());
+        ratio = static_cast<qreal>(size.width())/static_cast<qreal>(size.height());
+        ratioBis = static_cast<qreal>(size.height())/static_cast<qreal>(size.width());
         hasImage=true;
     }
 
-    QString key = m_pixList.key(pix);
     QStringList keyParts = key.split('_');
     if(!keyParts.isEmpty())
     {
         key = keyParts[0];
     }
-    text << "import QtQuick 2.4\n";
+    QHash<QString,QRect> atlas;
+    if(m_preferences->value("PackSmallImages",false).toBool())
+    {
+        atlas = m_imageModel->updateAtlas();
+    }
+    else
+    {
+        m_imageModel->removeAtlas();
+    }
+    // sourceClipRect, used to show atlas regions, needs QtQuick 2.15
+    text << (atlas.isEmpty() ? "import QtQuick 2.4\n" : "import QtQuick 2.15\n");
     text << "import QtQuick.Layouts 1.3\n";
     text << "import QtQuick.Controls 2.3\n";
     text << "import Rolisteam 1.0\n";
@@ -1325,17 +1682,21 @@ void MainWindow::generateQML(QString& qml)
         if(m_flickableSheet)
         {
             text << "       property real realscale: "<< m_fixedScaleSheet << "\n";
-            text << "       width: sourceSize.width*realscale" << "\n";
-            text << "       height: sourceSize.height*realscale" << "\n";
+            text << "       width: "<< size.width() << "*realscale" << "\n";
+            text << "       height: "<< size.height() << "*realscale" << "\n";
         }
         else
         {
-            text << "       property real realscale: width/"<< pix->width() << "\n";
+            text << "       property real realscale: width/"<< size.width() << "\n";
             text << "       width:(parent.width>parent.height*iratio)?iratio*parent.height:parent.width" << "\n";
             text << "       height:(parent.width>parent.height*iratio)?parent.height:iratiobis*parent.width" << "\n";
         }
+        // ask for the smallest reduced level (full width divided by a power of two) still larger than
+        // the displayed width, so only that level is decoded and uploaded.
+        text << "       sourceSize.width: Math.min("<< size.width() << ","<< size.width()
+             << "/Math.pow(2,Math.floor(Math.log("<< size.width() << "/width)/Math.LN2)))" << "\n";
         text << "       source: \"image://rcs/"+key+"_background_%1.jpg\".arg(root.page)" << "\n";
-        m_model->generateQML(text,1,false);
+        m_model->generateQML(text,1,false,atlas);
         text << "\n";
         text << "  }\n";
     }
@@ -1349,7 +1710,7 @@ void MainWindow::generateQML(QString& qml)
         {
             text << "    property real realscale: 1\n";
         }
-        m_model->generateQML(text,1,false);
+        m_model->generateQML(text,1,false,atlas);
     }
     if((!m_additionnalCodeTop) && (!m_additionnalCode.isEmpty()))
     {
@@ -1362,6 +1723,27 @@ void MainWindow::generateQML(QString& qml)
 }
 
 
+void MainWindow::bindItemsToContext()
+{
+    auto context = ui->m_quickview->engine()->rootContext();
+    QList<CharacterSheetItem *> list = m_model->children();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    // one call, the context refreshes its bindings once instead of once per field
+    QVector<QQmlContext::PropertyPair> properties;
+    properties.reserve(list.size());
+    for(CharacterSheetItem* item : list)
+    {
+        properties.append({item->getId(),QVariant::fromValue(static_cast<QObject*>(item))});
+    }
+    context->setContextProperties(properties);
+#else
+    for(CharacterSheetItem* item : list)
+    {
+        context->setContextProperty(item->getId(),item);
+    }
+#endif
+}
+
 void MainWindow::showQML()
 {
     if(m_editedTextByHand)
@@ -1379,7 +1761,6 @@ void MainWindow::showQML()
     generateQML(data);
     ui->m_codeEdit->setPlainText(data);
     m_editedTextByHand=false;
-    QSharedPointer<QHash<QString,QPixmap>> imgdata = m_imgProvider->getData();
 
     QTemporaryFile file;
     if(file.open())//QIODevice::WriteOnly
@@ -1397,14 +1778,7 @@ void MainWindow::showQML()
 
     }*/
     ui->m_quickview->engine()->clearComponentCache();
-    m_imgProvider = new RolisteamImageProvider();
-    m_imgProvider->setData(imgdata);
-    ui->m_quickview->engine()->addImageProvider(QLatin1String("rcs"),m_imgProvider);
-    QList<CharacterSheetItem *> list = m_model->children();
-    for(CharacterSheetItem* item : list)
-    {
-        ui->m_quickview->engine()->rootContext()->setContextProperty(item->getId(),item);
-    }
+    bindItemsToContext();
     connect(ui->m_quickview->engine(),&QQmlEngine::warnings,this,[=](const QList<QQmlError> &warning){
         displayWarningsQML(warning,LogController::Warning);
     });
@@ -1439,17 +1813,8 @@ void MainWindow::showQMLFromCode()
 
     //delete ui->m_quickview;
     ui->m_quickview->engine()->clearComponentCache();
-    QSharedPointer<QHash<QString,QPixmap>> imgdata = m_imgProvider->getData();
-    m_imgProvider = new RolisteamImageProvider();
-    m_imgProvider->setData(imgdata);
-    ui->m_quickview->engine()->addImageProvider("rcs",m_imgProvider);
 
-    QList<CharacterSheetItem *> list = m_model->children();
-    for(CharacterSheetItem* item : list)
-    {
-        //qDebug() <<"add item into qml" << item->getId();
-        ui->m_quickview->engine()->rootContext()->setContextProperty(item->getId(),item);
-    }
+    bindItemsToContext();
     ui->m_quickview->setSource(QUrl::fromLocalFile(file.fileName()));
     displayWarningsQML(ui->m_quickview->errors());
     ui->m_quickview->setResizeMode(QQuickWidget::SizeRootObjectToView);
@@ -1547,11 +1912,16 @@ void MainWindow::addImage()
     QString img = QFileDialog::getOpenFileName(this,tr("Open Background Image"),QDir::homePath(),supportedFormat);
     if(!img.isEmpty())
     {
-        QPixmap* pix = new QPixmap(img);
-        if(!pix->isNull())
+        QFile file(img);
+        if(!file.open(QIODevice::ReadOnly))
+            return;
+        QByteArray bytes = file.readAll();
+        QPixmap pix;
+        pix.loadFromData(bytes);
+        if(!pix.isNull())
         {
             QString fileName = QFileInfo(img).fileName();
-            m_imageModel->insertImage(pix,fileName,img,false);
+            m_imageModel->insertImage(bytes,fileName,img,false,pix);
         }
     }
 }
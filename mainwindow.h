@@ -27,10 +27,10 @@
 #include <QHash>
 #include <QPixmap>
 #include <QUndoStack>
+#include <QTimer>
 
 #include "canvas.h"
 #include "fieldmodel.h"
-#include "rolisteamimageprovider.h"
 #include "field.h"
 #include "charactersheetmodel.h"
 #include "pdfmanager.h"
@@ -41,7 +41,11 @@
 #include "common/controller/logcontroller.h"
 
 class CodeEditor;
+class CanvasField;
+class PageStrip;
+class MiniMap;
 class LogPanel;
+class QLabel;
 
 namespace Ui {
 class MainWindow;
@@ -90,11 +94,13 @@ public slots:
     void setFitInView();
     bool mayBeSaved();
     void modelChanged();
+    void syncCharacters();
     void displayWarningsQML(QList<QQmlError> list, LogController::LogLevel level = LogController::Error);
     void aboutRcse();
     void helpOnLine();
     void addImage();
     void copyPath();
+    void mergeImage(const QString& key, const QString& target);
 
     void exportPDF();
     void rollDice(QString cmd, bool b);
@@ -121,20 +127,28 @@ protected slots:
 private slots:
     void codeChanged();
     void sameGeometry();
+    void distribute();
+    void snapToGrid();
+    void duplicateIntoGrid();
 
 private:
     int pageCount();
+    void releaseUnusedPages();
+    QString backgroundId() const;
+    void updateBackground(Canvas* canvas);
+    void bindItemsToContext();
+    QList<CanvasField*> selectedFields() const;
+    void applyGeometries(const QList<CanvasField*>& fields, const QList<QRectF>& geometries, const QString& text);
 private:
     Ui::MainWindow *ui;
     QList<Canvas*> m_canvasList;
+    QList<Canvas*> m_pageUsage;
     ItemEditor* m_view;
     EDITION_TOOL m_currentTool;
     QPoint m_startField;
-    QHash<QString,QPixmap*> m_pixList;
     FieldModel* m_model;
     QString m_filename;
     bool m_qmlGeneration;
-    RolisteamImageProvider* m_imgProvider;
     CharacterSheetModel* m_characterModel;
     int m_currentPage;
     bool m_editedTextByHand;
@@ -163,6 +177,9 @@ private:
     QAction* m_alignOnX;
     QAction* m_sameWidth;
     QAction* m_sameHeight;
+    QAction* m_distributeH;
+    QAction* m_distributeV;
+    QAction* m_snapToGrid;
     QAction* m_dupplicate;
     QPoint m_posMenu;
 
@@ -170,6 +187,7 @@ private:
     QAction* m_copyPath;
     QAction* m_replaceImage;
     QAction* m_removeImage;
+    QAction* m_mergeImage;
 
     QString m_title;
     PreferencesManager* m_preferences;
@@ -183,7 +201,11 @@ private:
     qreal m_fixedScaleSheet;
 
     QUndoStack m_undoStack;
+    QTimer m_characterSyncTimer;
     CodeEditor* m_codeEdit;
+    QLabel* m_frameTime;
+    PageStrip* m_pageStrip;
+    MiniMap* m_miniMap;
 };
 
 #endif // MAINWINDOW_H
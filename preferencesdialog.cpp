@@ -31,6 +31,60 @@ bool PreferencesDialog::hasCustomPath()
 {
     return (ui->checkBox->checkState() == Qt::Checked);
 }
+int PreferencesDialog::imageCacheBudget() const
+{
+    return ui->m_imageCacheBudget->value();
+}
+
+void PreferencesDialog::setImageCacheBudget(int megaBytes)
+{
+    ui->m_imageCacheBudget->setValue(megaBytes);
+}
+
+int PreferencesDialog::pageMemoryBudget() const
+{
+    return ui->m_pageMemoryBudget->value();
+}
+
+void PreferencesDialog::setPageMemoryBudget(int megaBytes)
+{
+    ui->m_pageMemoryBudget->setValue(megaBytes);
+}
+
+void PreferencesDialog::setImageCacheStatistics(int hits, int misses, int usage)
+{
+    ui->m_imageCacheStats->setText(tr("%1 hit(s), %2 miss(es), %3 MB used").arg(hits).arg(misses).arg(usage));
+}
+
+bool PreferencesDialog::saveThumbnails() const
+{
+    return ui->m_saveThumbnails->isChecked();
+}
+
+void PreferencesDialog::setSaveThumbnails(bool b)
+{
+    ui->m_saveThumbnails->setChecked(b);
+}
+
+bool PreferencesDialog::packSmallImages() const
+{
+    return ui->m_packSmallImages->isChecked();
+}
+
+void PreferencesDialog::setPackSmallImages(bool b)
+{
+    ui->m_packSmallImages->setChecked(b);
+}
+
+bool PreferencesDialog::openGLViewport() const
+{
+    return ui->m_openGLViewport->isChecked();
+}
+
+void PreferencesDialog::setOpenGLViewport(bool b)
+{
+    ui->m_openGLViewport->setChecked(b);
+}
 void PreferencesDialog::selectDir()
 {
     QString path = QFileDialog::getExistingDirectory(this,tr("Directory to save QML file"),tr("Place to save Generated files"));
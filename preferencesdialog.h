@@ -19,6 +19,22 @@ public:
     void setGenerationPath(const QString &generationPath);
 
     bool hasCustomPath();
+
+    int imageCacheBudget() const;
+    void setImageCacheBudget(int megaBytes);
+    void setImageCacheStatistics(int hits, int misses, int usage);
+
+    int pageMemoryBudget() const;
+    void setPageMemoryBudget(int megaBytes);
+
+    bool saveThumbnails() const;
+    void setSaveThumbnails(bool b);
+
+    bool packSmallImages() const;
+    void setPackSmallImages(bool b);
+
+    bool openGLViewport() const;
+    void setOpenGLViewport(bool b);
 public slots:
     void selectDir();
 private:
@@ -24,6 +24,16 @@ QmlGeneratorVisitor::QmlGeneratorVisitor(QTextStream& out, CharacterSheetItem* r
     setIndentation(m_indentation);
 }
 
+QHash<QString,QRect> QmlGeneratorVisitor::atlas() const
+{
+    return m_atlas;
+}
+
+void QmlGeneratorVisitor::setAtlas(const QHash<QString,QRect>& atlas)
+{
+    m_atlas = atlas;
+}
+
 bool QmlGeneratorVisitor::isTable() const
 {
     return m_isTable;
@@ -465,6 +475,7 @@ bool QmlGeneratorVisitor::generateTable(Field *item)
     QmlGeneratorVisitor visitor(m_out,tablefield->getRoot());
     visitor.setIndentation(m_indentation+2);
     visitor.setIsTable(true);
+    visitor.setAtlas(m_atlas);
     visitor.generateCharacterSheetItem();
 
     m_out << end.arg(m_indenSpace);
@@ -478,6 +489,20 @@ bool QmlGeneratorVisitor::generateChangePageBtn(Field *item, bool next)
     if(!item)
         return false;
 
+    // the icon comes from the atlas when it has been packed, otherwise PageButton loads its own image.
+    QString imageKey = next ? QStringLiteral("nextpagebtn.png") : QStringLiteral("previouspagebtn.png");
+    QString image("%1    showImage:true\n");
+    if(m_atlas.contains(imageKey))
+    {
+        auto rect = m_atlas.value(imageKey);
+        image = QStringLiteral("%1    showImage:false\n"
+        "%1    Image {\n"
+        "%1        anchors.fill: parent\n"
+        "%1        fillMode: Image.PreserveAspectFit\n"
+        "%1        source: \"image://rcs/atlas.png\"\n"
+        "%1        sourceClipRect: Qt.rect(%2,%3,%4,%5)\n"
+        "%1    }\n").arg(m_indenSpace).arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height());
+    }
 
     QString node(
     "%1PageButton{//%2\n"
@@ -486,7 +511,7 @@ bool QmlGeneratorVisitor::generateChangePageBtn(Field *item, bool next)
     getToolTip(item)+
     generatePosition(item)+
     getPageManagement(item,m_indenSpace)+
-    "%1    showImage:true\n"
+    image+
     "%1    onClicked: {\n"
     "%1        root.page += next ? 1 : -1\n"
     "%1    }\n"
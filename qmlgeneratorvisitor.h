@@ -3,6 +3,8 @@
 
 
 #include <QTextStream>
+#include <QHash>
+#include <QRect>
 
 class CharacterSheetItem;
 class Field;
@@ -22,6 +24,9 @@ public:
     int indentation() const;
     void setIndentation(int indentation);
 
+    QHash<QString,QRect> atlas() const;
+    void setAtlas(const QHash<QString,QRect>& atlas);
+
 protected:
     bool generateTextInput(Field* item);
     bool generateTextArea(Field* item);
@@ -48,6 +53,7 @@ private:
     bool m_isTable = false;
     int m_indentation = 1;
     QString m_indenSpace;
+    QHash<QString,QRect> m_atlas;
 };
 
 #endif // QMLGENERATORVISITOR_H
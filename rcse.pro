@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui quickwidgets quick webengine printsupport svg
+QT       += core gui quickwidgets quick webengine printsupport svg concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -98,13 +98,24 @@ SOURCES += main.cpp\
     undo/addcharactercommand.cpp \
     undo/deletecharactercommand.cpp \
     undo/setpropertyonallcharacters.cpp \
+    undo/setgeometrycommand.cpp \
+    undo/duplicatefieldscommand.cpp \
     widgets/codeedit.cpp \
     delegate/pagedelegate.cpp \
+    delegate/encodingdelegate.cpp \
     codeeditordialog.cpp \
     widgets/fieldview.cpp \
+    widgets/pagestrip.cpp \
+    widgets/minimap.cpp \
     common/widgets/logpanel.cpp \
     common/controller/logcontroller.cpp \
-    qmlgeneratorvisitor.cpp
+    qmlgeneratorvisitor.cpp \
+    imagestore.cpp \
+    sheetimageprovider.cpp \
+    imageatlas.cpp \
+    tiledbackgrounditem.cpp \
+    spatialindex.cpp \
+    duplicatedialog.cpp
 
 HEADERS  += mainwindow.h \
     canvas.h \
@@ -135,13 +146,24 @@ HEADERS  += mainwindow.h \
     undo/addcharactercommand.h \
     undo/deletecharactercommand.h \
     undo/setpropertyonallcharacters.h \
+    undo/setgeometrycommand.h \
+    undo/duplicatefieldscommand.h \
     widgets/codeedit.h \
     delegate/pagedelegate.h \
+    delegate/encodingdelegate.h \
     codeeditordialog.h \
     widgets/fieldview.h \
+    widgets/pagestrip.h \
+    widgets/minimap.h \
     common/widgets/logpanel.h \
     common/controller/logcontroller.h \
-    qmlgeneratorvisitor.h
+    qmlgeneratorvisitor.h \
+    imagestore.h \
+    sheetimageprovider.h \
+    imageatlas.h \
+    tiledbackgrounditem.h \
+    spatialindex.h \
+    duplicatedialog.h
 
 
 
@@ -151,6 +173,7 @@ FORMS    += mainwindow.ui \
     preferencesdialog.ui \
     sheetproperties.ui \
     columndefinitiondialog.ui \
+    duplicatedialog.ui \
     widgets/codeedit.ui \
     codeeditordialog.ui \
     common/widgets/logpanel.ui
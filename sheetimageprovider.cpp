@@ -0,0 +1,86 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include "sheetimageprovider.h"
+
+SheetImageResponse::SheetImageResponse(QSharedPointer<ImageStore> store, const QString& id, const QSize& requestedSize)
+    : m_store(store),m_id(id),m_requestedSize(requestedSize),m_canceled(0)
+{
+    // the engine owns the response and deletes it once finished has been handled.
+    setAutoDelete(false);
+}
+
+void SheetImageResponse::run()
+{
+    if(m_canceled.load() || m_store.isNull())
+    {
+        notifyFinished();
+        return;
+    }
+
+    QImage img = m_store->image(m_id,m_requestedSize);
+
+    // the level is at most twice the requested size, only scale when it is larger.
+    if(!m_canceled.load() && !img.isNull() && !m_requestedSize.isEmpty()
+       && (img.width() > m_requestedSize.width() || img.height() > m_requestedSize.height()))
+    {
+        img = img.scaled(m_requestedSize,Qt::KeepAspectRatio,Qt::SmoothTransformation);
+    }
+    m_image = img;
+    notifyFinished();
+}
+
+void SheetImageResponse::notifyFinished()
+{
+    // run() may end before requestImageResponse() has returned and the reader has connected
+    // to finished, so it is emitted from the thread the response lives in.
+    QMetaObject::invokeMethod(this,"finished",Qt::QueuedConnection);
+}
+
+QQuickTextureFactory* SheetImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+QString SheetImageResponse::errorString() const
+{
+    if(m_image.isNull() && !m_canceled.load())
+        return QStringLiteral("Unknown image: %1").arg(m_id);
+    return QString();
+}
+
+void SheetImageResponse::cancel()
+{
+    m_canceled.store(1);
+}
+
+SheetImageProvider::SheetImageProvider(QSharedPointer<ImageStore> store)
+    : m_store(store)
+{
+
+}
+
+QQuickImageResponse* SheetImageProvider::requestImageResponse(const QString& id, const QSize& requestedSize)
+{
+    auto response = new SheetImageResponse(m_store,id,requestedSize);
+    m_pool.start(response);
+    return response;
+}
@@ -0,0 +1,80 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#ifndef SHEETIMAGEPROVIDER_H
+#define SHEETIMAGEPROVIDER_H
+
+#include <QQuickAsyncImageProvider>
+#include <QQuickImageResponse>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+#include "imagestore.h"
+
+/**
+ * @brief The SheetImageResponse class decodes and scales one image in the provider thread pool.
+ * A canceled request, a page the user has already left, stops before decoding.
+ */
+class SheetImageResponse : public QQuickImageResponse, public QRunnable
+{
+    Q_OBJECT
+public:
+    SheetImageResponse(QSharedPointer<ImageStore> store, const QString& id, const QSize& requestedSize);
+
+    void run() override;
+
+    QQuickTextureFactory* textureFactory() const override;
+    QString errorString() const override;
+
+public slots:
+    void cancel() override;
+
+private:
+    void notifyFinished();
+
+    QSharedPointer<ImageStore> m_store;
+    QString m_id;
+    QSize m_requestedSize;
+    QImage m_image;
+    QAtomicInt m_canceled;
+};
+
+/**
+ * @brief The SheetImageProvider class serves image://rcs/ urls to the QML preview.
+ * It reads straight from the ImageStore shared with ImageModel, nothing is copied.
+ * When QML sets a sourceSize, the closest reduced level of the store is served instead.
+ * Requests are asynchronous so turning pages never blocks the scene graph.
+ */
+class SheetImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    explicit SheetImageProvider(QSharedPointer<ImageStore> store);
+
+    QQuickImageResponse* requestImageResponse(const QString& id, const QSize& requestedSize) override;
+
+private:
+    QSharedPointer<ImageStore> m_store;
+    QThreadPool m_pool;
+};
+
+#endif // SHEETIMAGEPROVIDER_H
@@ -0,0 +1,119 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include "spatialindex.h"
+
+#include <QSet>
+#include <cmath>
+
+SpatialIndex::SpatialIndex(qreal cellSize)
+    : m_cellSize(cellSize)
+{
+
+}
+
+QRect SpatialIndex::cells(const QRectF& rect) const
+{
+    QPoint topLeft(static_cast<int>(std::floor(rect.left()/m_cellSize)),
+                   static_cast<int>(std::floor(rect.top()/m_cellSize)));
+    QPoint bottomRight(static_cast<int>(std::floor(rect.right()/m_cellSize)),
+                       static_cast<int>(std::floor(rect.bottom()/m_cellSize)));
+    return QRect(topLeft,bottomRight);
+}
+
+void SpatialIndex::insert(QGraphicsItem* item, const QRectF& rect)
+{
+    if(m_rects.contains(item))
+        remove(item);
+
+    m_rects.insert(item,rect);
+    QRect range = cells(rect);
+    for(int x = range.left(); x <= range.right(); ++x)
+    {
+        for(int y = range.top(); y <= range.bottom(); ++y)
+        {
+            m_cells[QPoint(x,y)].append(item);
+        }
+    }
+}
+
+void SpatialIndex::remove(QGraphicsItem* item)
+{
+    auto it = m_rects.find(item);
+    if(it == m_rects.end())
+        return;
+
+    QRect range = cells(it.value());
+    for(int x = range.left(); x <= range.right(); ++x)
+    {
+        for(int y = range.top(); y <= range.bottom(); ++y)
+        {
+            auto cell = m_cells.find(QPoint(x,y));
+            if(cell == m_cells.end())
+                continue;
+            cell.value().removeAll(item);
+            if(cell.value().isEmpty())
+                m_cells.erase(cell);
+        }
+    }
+    m_rects.erase(it);
+}
+
+void SpatialIndex::clear()
+{
+    m_cells.clear();
+    m_rects.clear();
+}
+
+bool SpatialIndex::isEmpty() const
+{
+    return m_rects.isEmpty();
+}
+
+QList<QGraphicsItem*> SpatialIndex::query(const QRectF& rect) const
+{
+    QList<QGraphicsItem*> result;
+    QSet<QGraphicsItem*> seen;
+    QRect range = cells(rect);
+    for(int x = range.left(); x <= range.right(); ++x)
+    {
+        for(int y = range.top(); y <= range.bottom(); ++y)
+        {
+            auto cell = m_cells.find(QPoint(x,y));
+            if(cell == m_cells.end())
+                continue;
+            for(auto item : cell.value())
+            {
+                // items spanning several cells are listed once
+                if(seen.contains(item) || !m_rects.value(item).intersects(rect))
+                    continue;
+                seen.insert(item);
+                result.append(item);
+            }
+        }
+    }
+    return result;
+}
+
+QRectF SpatialIndex::rect(QGraphicsItem* item) const
+{
+    return m_rects.value(item);
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QHash>
+#include <QPair>
+#include <QList>
+#include <QPoint>
+#include <QRectF>
+
+class QGraphicsItem;
+
+inline uint qHash(const QPoint& point, uint seed = 0)
+{
+    return qHash(qMakePair(point.x(),point.y()),seed);
+}
+
+/**
+ * @brief The SpatialIndex class buckets items into a uniform grid of scene cells.
+ * A rect query only visits the cells it covers, whatever the number of items on the page.
+ */
+class SpatialIndex
+{
+public:
+    SpatialIndex(qreal cellSize = 128);
+
+    void insert(QGraphicsItem* item, const QRectF& rect);
+    void remove(QGraphicsItem* item);
+    void clear();
+    bool isEmpty() const;
+
+    QList<QGraphicsItem*> query(const QRectF& rect) const;
+    QRectF rect(QGraphicsItem* item) const;
+
+private:
+    QRect cells(const QRectF& rect) const;
+
+private:
+    qreal m_cellSize;
+    QHash<QPoint,QList<QGraphicsItem*>> m_cells;
+    QHash<QGraphicsItem*,QRectF> m_rects;
+};
+
+#endif // SPATIALINDEX_H
@@ -26,6 +26,7 @@
 #include <QDebug>
 #include <QJsonArray>
 #include <QGraphicsSceneMouseEvent>
+#include <QTimer>
 
 #include "tablefield.h"
 #include "field.h"
@@ -61,6 +62,19 @@ QVariant HandleItem::itemChange(QGraphicsItem::GraphicsItemChange change, const
             return newPos;
         }
     }
+    else if(change == ItemSelectedHasChanged)
+    {
+        auto table = dynamic_cast<TableCanvasField*>(parentObject());
+        if(nullptr != table)
+            table->scheduleHandleVisibility();
+    }
+    else if(change == ItemPositionHasChanged)
+    {
+        // the separators are drawn by the table into its device cache
+        auto table = dynamic_cast<TableCanvasField*>(parentObject());
+        if(nullptr != table)
+            table->update();
+    }
     return QGraphicsItem::itemChange(change, value);
 
 }
@@ -155,6 +169,7 @@ TableCanvasField::TableCanvasField(Field* field)
     connect(m_dialog,&ColumnDefinitionDialog::positionChanged,this,[=](int i)
     {
         m_position=i;
+        updateChildrenLayout();
         update();
     });
 
@@ -181,6 +196,11 @@ TableCanvasField::TableCanvasField(Field* field)
 
     connect(m_addColumn,SIGNAL(clicked()),this,SLOT(addColumn()));
     connect(m_addLine,SIGNAL(clicked()),this,SLOT(addLine()));
+
+    // children are laid out when something they depend on changes, never from paint().
+    connect(this,&CanvasField::widthChanged,this,&TableCanvasField::updateChildrenLayout);
+    connect(this,&CanvasField::heightChanged,this,&TableCanvasField::updateChildrenLayout);
+    updateChildrenLayout();
 }
 TableCanvasField::~TableCanvasField()
 {
@@ -202,6 +222,7 @@ void TableCanvasField::addColumn()
     {
         item->setPos(colW*(m_handles.indexOf(item)+1),boundingRect().height()/2);
     }
+    updateChildrenLayout();
     if(m_columnDefined)
     {
         m_dataReset = true;
@@ -222,6 +243,7 @@ void TableCanvasField::removeColumn()
     {
         item->setPos(colW*(m_handles.indexOf(item)+1),boundingRect().height()/2);
     }
+    updateChildrenLayout();
     if(m_columnDefined)
     {
         m_dataReset = true;
@@ -285,7 +307,16 @@ void TableCanvasField::setColunmCount(int colunmCount)
     m_colunmCount = colunmCount;
 }
 
-void TableCanvasField::paint(QPainter *painter, const QStyleOptionGraphicsItem*,QWidget*)
+QVariant TableCanvasField::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    if(change == ItemSelectedHasChanged)
+    {
+        scheduleHandleVisibility();
+    }
+    return CanvasField::itemChange(change,value);
+}
+
+void TableCanvasField::updateChildrenLayout()
 {
     QPointF position;
     switch(static_cast<TableField::ControlPosition>(m_position))
@@ -324,7 +355,41 @@ void TableCanvasField::paint(QPainter *painter, const QStyleOptionGraphicsItem*,
         break;
     }
     m_addLineInGame->setPos(position);
-    
+
+    m_addLine->setPos(0,boundingRect().height()/2);
+    m_addColumn->setPos(boundingRect().width()/2,0);
+
+    scheduleHandleVisibility();
+}
+
+void TableCanvasField::scheduleHandleVisibility()
+{
+    // pressing a handle first clears the scene selection then selects the handle: hiding the
+    // handles in between would drop that press, so the visibility follows once events are done.
+    if(m_handleVisibilityPending)
+        return;
+    m_handleVisibilityPending = true;
+    QTimer::singleShot(0,this,&TableCanvasField::updateHandleVisibility);
+}
+
+void TableCanvasField::updateHandleVisibility()
+{
+    m_handleVisibilityPending = false;
+    bool visible = hasFocusOrChild();
+    for(auto handle : m_handles)
+    {
+        handle->setVisible(visible);
+    }
+    // the red frame is part of the cached rendering, repaint only when it comes or goes
+    if(visible != m_frameShown)
+    {
+        m_frameShown = visible;
+        update();
+    }
+}
+
+void TableCanvasField::paint(QPainter *painter, const QStyleOptionGraphicsItem*,QWidget*)
+{
     if(nullptr==m_field)
         return;
     painter->save();
@@ -332,9 +397,6 @@ void TableCanvasField::paint(QPainter *painter, const QStyleOptionGraphicsItem*,
     painter->setPen(Qt::black);
     painter->drawRect(m_rect);
 
-    m_addLine->setPos(0,boundingRect().height()/2);
-    m_addColumn->setPos(boundingRect().width()/2,0);
-
     if(hasFocusOrChild())
     {
         painter->save();
@@ -342,14 +404,14 @@ void TableCanvasField::paint(QPainter *painter, const QStyleOptionGraphicsItem*,
         pen.setColor(Qt::red);
         pen.setWidth(5);
         painter->setPen(pen);
-        painter->drawRect(m_rect);
+        // inset by half the pen width, the frame stays inside the bounding rect
+        painter->drawRect(m_rect.adjusted(2.5,2.5,-2.5,-2.5));
         painter->restore();
     }
 
     for(auto handle : m_handles)
     {
         painter->drawLine(handle->pos().x(),0,handle->pos().x(),boundingRect().height());
-        handle->setVisible(hasFocusOrChild());
     }
 
     auto yStep = boundingRect().height()/(m_lineCount);
@@ -375,14 +437,13 @@ void TableCanvasField::paint(QPainter *painter, const QStyleOptionGraphicsItem*,
                 }
                 auto itemType = field->getItemType();
                 auto fieldH = boundingRect().height()/m_lineCount;
+                QPixmap pix = m_showImageField ? typeIcon(itemType,painter->device()->devicePixelRatioF()) : QPixmap();
                 for(int y = 0; y < m_lineCount; ++y)
                 {
                     QRectF rect(xPos,y*yStep,xEnd,fieldH);
-                    QPixmap map = QPixmap(m_pictureMap[itemType]);
-                    m_pix=map.scaled(32,32);
-                    if((!m_pix.isNull())&& m_showImageField )
+                    if(!pix.isNull())
                     {
-                        painter->drawPixmap(rect.center(),m_pix,m_pix.rect());//-m_pix.rect().center()
+                        painter->drawPixmap(rect.center(),pix);//-pix.rect().center()
                     }
                     painter->save();
                     painter->setPen(Qt::green);
@@ -481,6 +542,7 @@ void TableCanvasField::load(QJsonObject &json, QList<QGraphicsScene *> scene)
         handleItem->load(obj);
         m_handles.append(handleItem);
     }
+    updateChildrenLayout();
 
     QJsonObject dialog = json["dialog"].toObject();
     m_dialog->load(dialog,scene);
@@ -509,6 +571,7 @@ void TableCanvasField::save(QJsonObject &json)
 void TableCanvasField::setPositionAddLine(int pos)
 {
     m_position = pos;
+    updateChildrenLayout();
 }
 //////////////////////////////////////////////////////
 //
@@ -142,7 +142,13 @@ public:
 
     CharacterSheetItem* getRoot();
 
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
+    void scheduleHandleVisibility();
+
 public slots:
+    void updateChildrenLayout();
+    void updateHandleVisibility();
     void addColumn();
     void removeColumn();
     void addLine();
@@ -166,6 +172,8 @@ private:
     bool m_dataReset;
     int m_position;
     bool m_columnDefined = false;
+    bool m_handleVisibilityPending = false;
+    bool m_frameShown = false;
 };
 
 #endif // TABLECANVASFIELD_H
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_fieldmodel
+
+SOURCES += tst_fieldmodel.cpp
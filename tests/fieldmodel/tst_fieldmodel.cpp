@@ -0,0 +1,165 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include <QtTest>
+#include <QSignalSpy>
+
+#include "field.h"
+#include "fieldmodel.h"
+
+#define FIELD_COUNT 1000
+#define PAGE_COUNT 10
+
+class FieldModelTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+
+    void bulkEditNotifiesOnce();
+    void bulkEdit();
+    void pageIndexFollowsEdits();
+    void fieldsFromPage();
+
+private:
+    void editAll(int width);
+    void spreadOverPages();
+
+    FieldModel* m_model = nullptr;
+    QList<CSItem*> m_fields;
+};
+
+void FieldModelTest::init()
+{
+    m_model = new FieldModel();
+    for(int i = 0; i < FIELD_COUNT; ++i)
+    {
+        m_fields.append(new Field(QPointF(i,i)));
+    }
+    m_model->appendFields(m_fields);
+}
+
+void FieldModelTest::cleanup()
+{
+    delete m_model;
+    m_model = nullptr;
+    m_fields.clear();
+}
+
+void FieldModelTest::editAll(int width)
+{
+    m_model->beginTransaction();
+    for(auto field : m_fields)
+    {
+        field->setValueFrom(CharacterSheetItem::WIDTH,width);
+    }
+    m_model->commitTransaction();
+}
+
+void FieldModelTest::spreadOverPages()
+{
+    m_model->beginTransaction();
+    for(int i = 0; i < m_fields.size(); ++i)
+    {
+        m_fields[i]->setValueFrom(CharacterSheetItem::PAGE,i%PAGE_COUNT);
+    }
+    m_model->commitTransaction();
+}
+
+void FieldModelTest::bulkEditNotifiesOnce()
+{
+    QSignalSpy dataChanged(m_model,&QAbstractItemModel::dataChanged);
+    QSignalSpy modelChanged(m_model,&FieldModel::modelChanged);
+
+    editAll(42);
+
+    QCOMPARE(dataChanged.count(),1);
+    QCOMPARE(modelChanged.count(),1);
+
+    // the single range covers every edited row
+    auto first = dataChanged.first().at(0).value<QModelIndex>();
+    auto last = dataChanged.first().at(1).value<QModelIndex>();
+    QCOMPARE(first.row(),0);
+    QCOMPARE(last.row(),FIELD_COUNT-1);
+}
+
+void FieldModelTest::bulkEdit()
+{
+    int width = 0;
+    QBENCHMARK
+    {
+        editAll(++width);
+    }
+}
+
+void FieldModelTest::pageIndexFollowsEdits()
+{
+    spreadOverPages();
+
+    QList<CharacterSheetItem*> list;
+    m_model->getFieldFromPage(3,list);
+    QCOMPARE(list.size(),FIELD_COUNT/PAGE_COUNT);
+    // model order
+    for(int i = 0; i < list.size(); ++i)
+    {
+        QCOMPARE(list.at(i),static_cast<CharacterSheetItem*>(m_fields.at(3+i*PAGE_COUNT)));
+    }
+
+    // the first page goes away, the others move a page back
+    list.clear();
+    m_model->getFieldFromPage(0,list);
+    QList<CSItem*> removed;
+    for(auto item : list)
+    {
+        removed.append(static_cast<CSItem*>(item));
+    }
+    m_model->removeFields(removed);
+    m_model->removePageId(0);
+
+    list.clear();
+    m_model->getFieldFromPage(0,list);
+    QCOMPARE(list.size(),FIELD_COUNT/PAGE_COUNT);
+    QCOMPARE(list.first(),static_cast<CharacterSheetItem*>(m_fields.at(1)));
+    QCOMPARE(list.first()->getPage(),0);
+
+    list.clear();
+    m_model->getFieldFromPage(PAGE_COUNT-1,list);
+    QVERIFY(list.isEmpty());
+    qDeleteAll(removed);
+}
+
+void FieldModelTest::fieldsFromPage()
+{
+    spreadOverPages();
+    QBENCHMARK
+    {
+        for(int page = 0; page < PAGE_COUNT; ++page)
+        {
+            QList<CharacterSheetItem*> list;
+            m_model->getFieldFromPage(page,list);
+        }
+    }
+}
+
+QTEST_MAIN(FieldModelTest)
+
+#include "tst_fieldmodel.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_imagemodel
+
+SOURCES += tst_imagemodel.cpp
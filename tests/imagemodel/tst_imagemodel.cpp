@@ -0,0 +1,114 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include <QtTest>
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "canvas.h"
+#include "imagemodel.h"
+#include "imagestore.h"
+
+#define IMAGE_SIZE 256
+
+class ImageModelTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void mergeSharesBytes();
+
+private:
+    static QImage picture(int shift);
+    static QByteArray encode(const QImage& img, const char* format);
+    static int savedSize(ImageModel& model);
+};
+
+QImage ImageModelTest::picture(int shift)
+{
+    // a gradient with fine noise: the hash sees the gradient, lossless encoders pay for the noise.
+    QImage img(IMAGE_SIZE,IMAGE_SIZE,QImage::Format_RGB32);
+    qsrand(42);
+    for(int y = 0; y < IMAGE_SIZE; ++y)
+    {
+        for(int x = 0; x < IMAGE_SIZE; ++x)
+        {
+            int value = 20 + (x * 160) / IMAGE_SIZE + (y * 40) / IMAGE_SIZE + qrand() % 8 + shift;
+            img.setPixel(x,y,qRgb(value,value/2,255-value));
+        }
+    }
+    return img;
+}
+
+QByteArray ImageModelTest::encode(const QImage& img, const char* format)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    img.save(&buffer,format,90);
+    return bytes;
+}
+
+int ImageModelTest::savedSize(ImageModel& model)
+{
+    int size = 0;
+    for(const auto& value : model.save())
+    {
+        size += value.toObject()["bin"].toString().size();
+    }
+    return size;
+}
+
+void ImageModelTest::mergeSharesBytes()
+{
+    ImageModel model;
+    auto target = QStringLiteral("{target}_background_0.jpg");
+    auto duplicate = QStringLiteral("{target}_background_1.jpg");
+
+    QVERIFY(model.insertImage(encode(picture(0),"JPEG"),target,"target.jpg",true));
+    QVERIFY(model.insertImage(encode(picture(4),"PNG"),duplicate,"duplicate.png",true));
+    model.setEncoding(target,ImageEncoding::Jpeg,90);
+    model.setEncoding(duplicate,ImageEncoding::Png,90);
+
+    // hashes are computed with the thumbnails, in the thread pool
+    QTRY_COMPARE(model.duplicateOf(duplicate),target);
+    int before = savedSize(model);
+
+    QVERIFY(model.mergeImage(duplicate,target));
+    QVERIFY(model.duplicateOf(duplicate).isEmpty());
+
+    auto store = model.store();
+    auto bytes = store->imageData(target).m_data;
+    QCOMPARE(store->imageData(duplicate).m_data.constData(),bytes.constData());
+
+    // the page of the duplicate shows the very same bytes, nothing is copied nor stored again
+    Canvas canvas;
+    canvas.setImageModel(&model);
+    canvas.setBackground(bytes);
+    QCOMPARE(canvas.backgroundData().constData(),bytes.constData());
+    QVERIFY(!model.replaceImage(duplicate,canvas.backgroundData()));
+
+    QVERIFY(savedSize(model) < before);
+}
+
+QTEST_MAIN(ImageModelTest)
+
+#include "tst_imagemodel.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_tablecanvasfield
+
+SOURCES += tst_tablecanvasfield.cpp
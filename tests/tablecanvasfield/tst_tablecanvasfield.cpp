@@ -0,0 +1,175 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include <QtTest>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QImage>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include "tablefield.h"
+#include "tablecanvasfield.h"
+
+#define COLUMN_COUNT 20
+#define LINE_COUNT 50
+
+class CountingTableCanvasField : public TableCanvasField
+{
+public:
+    explicit CountingTableCanvasField(Field* field)
+        : TableCanvasField(field)
+    {
+    }
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override
+    {
+        ++m_paintCount;
+        TableCanvasField::paint(painter,option,widget);
+    }
+
+    int m_paintCount = 0;
+};
+
+class TableCanvasFieldTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+
+    void paintOncePerChange();
+    void repaintOnHandleMove();
+    void repaintLargeTable();
+
+private:
+    void settle(QGraphicsView& view);
+
+    TableField* m_field = nullptr;
+    CountingTableCanvasField* m_canvasField = nullptr;
+};
+
+void TableCanvasFieldTest::init()
+{
+    m_field = new TableField();
+    m_canvasField = new CountingTableCanvasField(m_field);
+    m_canvasField->setNewEnd(QPointF(800,1000));
+}
+
+void TableCanvasFieldTest::cleanup()
+{
+    delete m_canvasField;
+    m_canvasField = nullptr;
+    delete m_field;
+    m_field = nullptr;
+}
+
+void TableCanvasFieldTest::settle(QGraphicsView& view)
+{
+    // flush the deferred handle layout, then the scene change notification
+    QCoreApplication::processEvents();
+    QCoreApplication::processEvents();
+    // paint now instead of waiting for the window system
+    view.viewport()->repaint();
+}
+
+void TableCanvasFieldTest::paintOncePerChange()
+{
+    QGraphicsScene scene;
+    scene.addItem(m_canvasField);
+    QGraphicsView view(&scene);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+    settle(view);
+    m_canvasField->m_paintCount = 0;
+
+    // nothing changed: the view is served from the item cache
+    view.viewport()->update();
+    settle(view);
+    QCOMPARE(m_canvasField->m_paintCount,0);
+
+    m_canvasField->setWidth(600);
+    settle(view);
+    QCOMPARE(m_canvasField->m_paintCount,1);
+
+    m_canvasField->addLine();
+    settle(view);
+    QCOMPARE(m_canvasField->m_paintCount,2);
+
+    m_canvasField->addColumn();
+    settle(view);
+    QCOMPARE(m_canvasField->m_paintCount,3);
+
+    // the scene must not delete the item, cleanup() does
+    scene.removeItem(m_canvasField);
+}
+
+void TableCanvasFieldTest::repaintOnHandleMove()
+{
+    m_canvasField->addColumn();
+    HandleItem* handle = nullptr;
+    for(auto child : m_canvasField->childItems())
+    {
+        handle = dynamic_cast<HandleItem*>(child);
+        if(nullptr != handle)
+            break;
+    }
+    QVERIFY(nullptr != handle);
+
+    QGraphicsScene scene;
+    scene.addItem(m_canvasField);
+    QGraphicsView view(&scene);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+    settle(view);
+    m_canvasField->m_paintCount = 0;
+
+    // the separator follows the handle, the cached table must be drawn again
+    handle->setPos(handle->pos()+QPointF(40,0));
+    settle(view);
+    QCOMPARE(m_canvasField->m_paintCount,1);
+
+    scene.removeItem(m_canvasField);
+}
+
+void TableCanvasFieldTest::repaintLargeTable()
+{
+    // the table starts with one column
+    for(int i = 1; i < COLUMN_COUNT; ++i)
+    {
+        m_canvasField->addColumn();
+    }
+    m_canvasField->setLineCount(LINE_COUNT);
+    QCOMPARE(m_canvasField->colunmCount(),COLUMN_COUNT);
+
+    QImage image(m_canvasField->boundingRect().size().toSize(),QImage::Format_ARGB32_Premultiplied);
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = m_canvasField->boundingRect();
+    QBENCHMARK
+    {
+        QPainter painter(&image);
+        m_canvasField->paint(&painter,&option,nullptr);
+    }
+}
+
+QTEST_MAIN(TableCanvasFieldTest)
+
+#include "tst_tablecanvasfield.moc"
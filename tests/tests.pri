@@ -0,0 +1,60 @@
+# Shared settings of the unit tests: the editor sources they exercise, without the main window.
+QT       += core gui widgets quickwidgets quick webengine svg concurrent testlib
+
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+DEFINES+=RCSE
+CONFIG+=RCSE
+
+ROOT = $$PWD/..
+
+include($$ROOT/charactersheet/charactersheet.pri)
+include($$ROOT/diceparser/diceparser.pri)
+
+INCLUDEPATH += $$ROOT/charactersheet $$ROOT
+
+SOURCES += $$ROOT/canvas.cpp \
+    $$ROOT/canvasfield.cpp \
+    $$ROOT/tablecanvasfield.cpp \
+    $$ROOT/fieldmodel.cpp \
+    $$ROOT/columndefinitiondialog.cpp \
+    $$ROOT/borderlisteditor.cpp \
+    $$ROOT/qmlgeneratorvisitor.cpp \
+    $$ROOT/imagemodel.cpp \
+    $$ROOT/imagestore.cpp \
+    $$ROOT/imageatlas.cpp \
+    $$ROOT/tiledbackgrounditem.cpp \
+    $$ROOT/spatialindex.cpp \
+    $$ROOT/delegate/alignmentdelegate.cpp \
+    $$ROOT/delegate/fontdelegate.cpp \
+    $$ROOT/delegate/pagedelegate.cpp \
+    $$ROOT/delegate/typedelegate.cpp \
+    $$ROOT/undo/addfieldcommand.cpp \
+    $$ROOT/undo/deletefieldcommand.cpp \
+    $$ROOT/undo/movefieldcommand.cpp \
+    $$ROOT/undo/setbackgroundimage.cpp
+
+HEADERS += $$ROOT/canvas.h \
+    $$ROOT/canvasfield.h \
+    $$ROOT/tablecanvasfield.h \
+    $$ROOT/fieldmodel.h \
+    $$ROOT/columndefinitiondialog.h \
+    $$ROOT/borderlisteditor.h \
+    $$ROOT/qmlgeneratorvisitor.h \
+    $$ROOT/imagemodel.h \
+    $$ROOT/imagestore.h \
+    $$ROOT/imageatlas.h \
+    $$ROOT/tiledbackgrounditem.h \
+    $$ROOT/spatialindex.h \
+    $$ROOT/delegate/alignmentdelegate.h \
+    $$ROOT/delegate/fontdelegate.h \
+    $$ROOT/delegate/pagedelegate.h \
+    $$ROOT/delegate/typedelegate.h \
+    $$ROOT/undo/addfieldcommand.h \
+    $$ROOT/undo/deletefieldcommand.h \
+    $$ROOT/undo/movefieldcommand.h \
+    $$ROOT/undo/setbackgroundimage.h
+
+FORMS += $$ROOT/columndefinitiondialog.ui
@@ -0,0 +1,175 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#include "tiledbackgrounditem.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtConcurrent>
+#include <QtMath>
+
+#define TILE_SIZE 512
+#define MAX_LEVEL 5
+
+TiledBackgroundItem::TiledBackgroundItem(QGraphicsItem* parent)
+    : QGraphicsPixmapItem(parent)
+{
+    // gives an accurate exposedRect to paint()
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption,true);
+    setTransformationMode(Qt::SmoothTransformation);
+    QObject::connect(&m_watcher,&QFutureWatcher<Levels>::finished,&m_watcher,[this](){
+        levelsReady();
+    });
+}
+
+void TiledBackgroundItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    Q_UNUSED(widget);
+    const QPixmap& source = pixmap();
+    if(source.isNull())
+        return;
+
+    if(source.cacheKey() != m_sourceKey)
+        prepareLevels();
+
+    qreal scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if(nullptr != painter->device())
+        scale *= painter->device()->devicePixelRatioF();
+
+    QRectF exposed = option->exposedRect.intersected(QRectF(source.rect()));
+    painter->setRenderHint(QPainter::SmoothPixmapTransform,true);
+
+    // levels still in the works: the source is the nearest one available
+    int index = qMin(levelFor(scale),qMax(0,m_levels.size()-1));
+    if(index == 0)
+    {
+        // full resolution: only the exposed part of the source is drawn.
+        painter->drawPixmap(exposed,source,exposed);
+        return;
+    }
+
+    const Level& lod = m_levels.at(index);
+    const qreal tileSize = TILE_SIZE << index; // in item coordinates
+    int rows = lod.m_columns > 0 ? lod.m_tiles.size()/lod.m_columns : 0;
+    int firstColumn = qMax(0,static_cast<int>(exposed.left()/tileSize));
+    int lastColumn = qMin(lod.m_columns-1,static_cast<int>(exposed.right()/tileSize));
+    int firstRow = qMax(0,static_cast<int>(exposed.top()/tileSize));
+    int lastRow = qMin(rows-1,static_cast<int>(exposed.bottom()/tileSize));
+    for(int row = firstRow; row <= lastRow; ++row)
+    {
+        for(int column = firstColumn; column <= lastColumn; ++column)
+        {
+            const QPixmap& tile = lod.m_tiles.at(row*lod.m_columns+column);
+            QRectF target(column*tileSize,row*tileSize,tile.width() << index,tile.height() << index);
+            painter->drawPixmap(target,tile,QRectF(tile.rect()));
+        }
+    }
+}
+
+void TiledBackgroundItem::prepareLevels()
+{
+    const QPixmap& source = pixmap();
+    if(source.isNull())
+    {
+        releaseLevels();
+        return;
+    }
+    qint64 key = source.cacheKey();
+    if(key == m_sourceKey || key == m_pendingKey)
+        return;
+
+    // the levels of the previous pixmap are of no use, a running build is ignored when it ends.
+    m_levels.clear();
+    m_sourceKey = 0;
+    m_pendingKey = key;
+    m_watcher.setFuture(QtConcurrent::run(&TiledBackgroundItem::buildLevels,source.toImage(),key));
+}
+
+void TiledBackgroundItem::releaseLevels()
+{
+    m_sourceKey = 0;
+    m_pendingKey = 0;
+    m_levels.clear();
+    m_levels.squeeze();
+}
+
+void TiledBackgroundItem::levelsReady()
+{
+    Levels result = m_watcher.result();
+    if(result.m_sourceKey != m_pendingKey || result.m_sourceKey != pixmap().cacheKey())
+        return;
+
+    // pixmaps are only made in the GUI thread
+    m_pendingKey = 0;
+    m_sourceKey = result.m_sourceKey;
+    m_levels.resize(result.m_levels.size());
+    for(int index = 1; index < result.m_levels.size(); ++index)
+    {
+        const ImageLevel& images = result.m_levels.at(index);
+        Level& lod = m_levels[index];
+        lod.m_columns = images.m_columns;
+        lod.m_tiles.reserve(images.m_tiles.size());
+        for(const auto& tile : images.m_tiles)
+        {
+            lod.m_tiles.append(QPixmap::fromImage(tile));
+        }
+    }
+    update();
+}
+
+int TiledBackgroundItem::levelFor(qreal scale) const
+{
+    // the smallest level still at least as detailed as the screen
+    if(scale >= 1.0 || scale <= 0.0)
+        return 0;
+    int index = qFloor(std::log2(1.0/scale));
+    return qBound(0,index,MAX_LEVEL);
+}
+
+TiledBackgroundItem::Levels TiledBackgroundItem::buildLevels(const QImage& source, qint64 sourceKey)
+{
+    Levels levels;
+    levels.m_sourceKey = sourceKey;
+    levels.m_levels.resize(MAX_LEVEL+1);
+
+    // each level is the previous one at half size, then cut into tiles.
+    QImage reduced = source;
+    for(int index = 1; index <= MAX_LEVEL; ++index)
+    {
+        QSize size(qMax(1,source.width() >> index),qMax(1,source.height() >> index));
+        reduced = reduced.scaled(size,Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
+
+        ImageLevel& lod = levels.m_levels[index];
+        lod.m_columns = (size.width()+TILE_SIZE-1)/TILE_SIZE;
+        int rows = (size.height()+TILE_SIZE-1)/TILE_SIZE;
+        lod.m_tiles.reserve(lod.m_columns*rows);
+        for(int row = 0; row < rows; ++row)
+        {
+            for(int column = 0; column < lod.m_columns; ++column)
+            {
+                lod.m_tiles.append(reduced.copy(column*TILE_SIZE,row*TILE_SIZE,
+                                                qMin(TILE_SIZE,size.width()-column*TILE_SIZE),
+                                                qMin(TILE_SIZE,size.height()-row*TILE_SIZE)));
+            }
+        }
+    }
+    return levels;
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+* Copyright (C) 2019 by Renaud Guezennec                                   *
+* http://www.rolisteam.org/                                                *
+*                                                                          *
+*  This file is part of rcse                                               *
+*                                                                          *
+* rcse is free software; you can redistribute it and/or modify             *
+* it under the terms of the GNU General Public License as published by     *
+* the Free Software Foundation; either version 2 of the License, or        *
+* (at your option) any later version.                                      *
+*                                                                          *
+* rcse is distributed in the hope that it will be useful,                  *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the             *
+* GNU General Public License for more details.                             *
+*                                                                          *
+* You should have received a copy of the GNU General Public License        *
+* along with this program; if not, write to the                            *
+* Free Software Foundation, Inc.,                                          *
+* 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.                 *
+***************************************************************************/
+#ifndef TILEDBACKGROUNDITEM_H
+#define TILEDBACKGROUNDITEM_H
+
+#include <QFutureWatcher>
+#include <QGraphicsPixmapItem>
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+
+/**
+ * @brief The TiledBackgroundItem class draws the page background by tiles.
+ * Reduced levels (half, quarter...) are computed in the thread pool when the pixmap is set,
+ * the level matching the zoom is picked at paint time and only the tiles intersecting the
+ * exposed rect are drawn. Until the levels are ready the source itself is drawn.
+ */
+class TiledBackgroundItem : public QGraphicsPixmapItem
+{
+public:
+    TiledBackgroundItem(QGraphicsItem* parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+    /**
+     * @brief prepareLevels starts building the reduced levels of the current pixmap, if not done yet.
+     */
+    void prepareLevels();
+    /**
+     * @brief releaseLevels frees the reduced levels, they are rebuilt when the pixmap is set again.
+     */
+    void releaseLevels();
+
+private:
+    struct Level
+    {
+        int m_columns = 0;
+        QVector<QPixmap> m_tiles;
+    };
+    struct ImageLevel
+    {
+        int m_columns = 0;
+        QVector<QImage> m_tiles;
+    };
+    struct Levels
+    {
+        qint64 m_sourceKey = 0;
+        QVector<ImageLevel> m_levels;
+    };
+    static Levels buildLevels(const QImage& source, qint64 sourceKey);
+    void levelsReady();
+    int levelFor(qreal scale) const;
+
+private:
+    qint64 m_sourceKey = 0;
+    qint64 m_pendingKey = 0;
+    QVector<Level> m_levels; // index 0 is the source, never stored
+    QFutureWatcher<Levels> m_watcher;
+};
+
+#endif // TILEDBACKGROUNDITEM_H
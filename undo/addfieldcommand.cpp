@@ -158,7 +158,7 @@ void AddFieldCommand::redo()
       }
       if(!path.isEmpty())
       {
-        auto pix = new QPixmap(path);
+        QPixmap pix(path);
         m_addImage = m_imageModel->insertImage(pix,key,path,false);
       }
   }
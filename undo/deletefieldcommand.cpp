@@ -46,10 +46,9 @@ void DeleteFieldCommand::init()
     {
         if(nullptr != field->getCanvasField())
         {
-           auto parent = field->getParent();
            m_parent.append(field->getParent());
            m_points.append(field->getCanvasField()->pos());
-           m_posInModel.append(parent->indexOfChild(field));
+           m_posInModel.append(m_model->rowOf(field));
         }
     }
 
@@ -68,9 +67,18 @@ void DeleteFieldCommand::undo()
 
 void DeleteFieldCommand::redo()
 {
+    // top level fields go in one batch, the row index is rebuilt once
+    QList<CSItem*> topLevel;
     for(int i = 0; i < m_fields.size(); ++i)
     {
-        m_canvas[i]->removeItem(m_fields[i]->getCanvasField());
-        m_model->removeField(m_fields[i]);
+        auto item = m_fields[i]->getCanvasField();
+        // out of the scene already when its page is released
+        if(item->scene() == m_canvas[i])
+            m_canvas[i]->removeItem(item);
+        if(m_fields[i]->getParent() == m_model->getRootSection())
+            topLevel.append(m_fields[i]);
+        else
+            m_model->removeField(m_fields[i]);
     }
+    m_model->removeFields(topLevel);
 }
@@ -29,7 +29,8 @@ DeletePageCommand::DeletePageCommand(int currentPage, QList<Canvas*>& list,Field
     for(auto item : m_subField)
     {
         auto field = dynamic_cast<Field*>(item);
-        m_subCanvas.append(dynamic_cast<Canvas*>(field->getCanvasField()->scene()));
+        // the page may have released its items, the field still belongs to its canvas
+        m_subCanvas.append(m_canvas);
         m_subCurrentPage.append(field->getPage());
     }
     m_deleteField = new DeleteFieldCommand(m_subField,m_subCanvas,m_model,m_subCurrentPage,this);
@@ -39,10 +40,13 @@ DeletePageCommand::DeletePageCommand(int currentPage, QList<Canvas*>& list,Field
 void DeletePageCommand::undo()
 {
     m_list.insert(m_currentPage,m_canvas);
+    renumberCanvas();
     QStringList str = m_pagesModel->stringList();
     str.insert(m_currentPage,QObject::tr("Page %1").arg(m_currentPage+1));
     m_pagesModel->setStringList(str);
 
+    // the fields of the next pages go back to their place before the deleted ones come back
+    m_model->insertPageId(m_currentPage);
     QUndoCommand::undo();
 }
 
@@ -54,6 +58,16 @@ void DeletePageCommand::redo()
     m_pagesModel->setStringList(str);
 
     QUndoCommand::redo();
+    m_model->removePageId(m_currentPage);
+    renumberCanvas();
+}
+
+void DeletePageCommand::renumberCanvas()
+{
+    for(int i = m_currentPage; i < m_list.size(); ++i)
+    {
+        m_list[i]->setCurrentPage(i);
+    }
 }
 
 Canvas* DeletePageCommand::canvas() const
@@ -42,6 +42,8 @@ public:
   static void setPagesModel(QStringListModel* pagesModel);
 
 private:
+  void renumberCanvas();
+
   int m_currentPage;
   Canvas* m_canvas;
   QList<Canvas*>& m_list;
@@ -0,0 +1,110 @@
+/***************************************************************************
+    *	 Copyright (C) 2019 by Renaud Guezennec                                *
+    *   http://www.rolisteam.org/contact                   *
+    *                                                                         *
+    *   This program is free software; you can redistribute it and/or modify  *
+    *   it under the terms of the GNU General Public License as published by  *
+    *   the Free Software Foundation; either version 2 of the License, or     *
+    *   (at your option) any later version.                                   *
+    *                                                                         *
+    *   This program is distributed in the hope that it will be useful,       *
+    *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+    *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+    *   GNU General Public License for more details.                          *
+    *                                                                         *
+    *   You should have received a copy of the GNU General Public License     *
+    *   along with this program; if not, write to the                         *
+    *   Free Software Foundation, Inc.,                                       *
+    *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+    ***************************************************************************/
+#include "duplicatefieldscommand.h"
+
+#include <QRegularExpression>
+
+#include "canvas.h"
+#include "field.h"
+#include "fieldmodel.h"
+
+DuplicateFieldsCommand::DuplicateFieldsCommand(Canvas* canvas, FieldModel* model, QList<Field*> sources, int rows, int columns,
+                                               qreal hSpacing, qreal vSpacing, QUndoCommand* parent)
+  : QUndoCommand(parent),m_canvas(canvas),m_model(model)
+{
+    QRectF area;
+    for(auto source : sources)
+    {
+        area |= source->getCanvasField()->sceneBoundingRect();
+    }
+
+    // ids given by this batch, the model index knows the others
+    QSet<QString> used;
+
+    for(int r = 0; r < rows; ++r)
+    {
+        for(int c = 0; c < columns; ++c)
+        {
+            int step = r*columns+c;
+            if(step == 0)
+                continue;
+
+            QPointF offset(c*(area.width()+hSpacing),r*(area.height()+vSpacing));
+            for(auto source : sources)
+            {
+                QPointF pos = source->getCanvasField()->pos()+offset;
+                auto copy = new Field(pos);
+                copy->copyField(source,true,false);
+                copy->setPage(m_canvas->currentPage());
+                copy->setValueFrom(CharacterSheetItem::X,pos.x());
+                copy->setValueFrom(CharacterSheetItem::Y,pos.y());
+                copy->setValueFrom(CharacterSheetItem::WIDTH,source->getCanvasField()->boundingRect().width());
+                copy->setValueFrom(CharacterSheetItem::HEIGHT,source->getCanvasField()->boundingRect().height());
+                copy->setValueFrom(CharacterSheetItem::ID,nextId(m_model,source->getId(),step,used));
+                m_copies.append(copy);
+            }
+        }
+    }
+    setText(QObject::tr("Duplicate %n Field(s)","",m_copies.size()));
+}
+
+QString DuplicateFieldsCommand::nextId(FieldModel* model, const QString& id, int step, QSet<QString>& used)
+{
+    // skill1 gives skill2, skill3... ids without number get a suffix.
+    static const QRegularExpression trailingNumber(QStringLiteral("^(.*?)(\\d+)$"));
+    auto match = trailingNumber.match(id);
+    QString prefix = id + QStringLiteral("_");
+    int number = 0;
+    int width = 0;
+    if(match.hasMatch())
+    {
+        prefix = match.captured(1);
+        number = match.captured(2).toInt();
+        width = match.captured(2).size();
+    }
+
+    QString result;
+    do
+    {
+        result = prefix + QStringLiteral("%1").arg(number+step,width,10,QChar('0'));
+        ++step;
+    } while(used.contains(result) || nullptr != model->itemById(result));
+
+    used.insert(result);
+    return result;
+}
+
+void DuplicateFieldsCommand::undo()
+{
+    for(auto copy : m_copies)
+    {
+        m_canvas->removeItem(static_cast<Field*>(copy)->getCanvasField());
+    }
+    m_model->removeFields(m_copies);
+}
+
+void DuplicateFieldsCommand::redo()
+{
+    for(auto copy : m_copies)
+    {
+        m_canvas->addItem(static_cast<Field*>(copy)->getCanvasField());
+    }
+    m_model->appendFields(m_copies);
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+    *	 Copyright (C) 2019 by Renaud Guezennec                                *
+    *   http://www.rolisteam.org/contact                   *
+    *                                                                         *
+    *   This program is free software; you can redistribute it and/or modify  *
+    *   it under the terms of the GNU General Public License as published by  *
+    *   the Free Software Foundation; either version 2 of the License, or     *
+    *   (at your option) any later version.                                   *
+    *                                                                         *
+    *   This program is distributed in the hope that it will be useful,       *
+    *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+    *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+    *   GNU General Public License for more details.                          *
+    *                                                                         *
+    *   You should have received a copy of the GNU General Public License     *
+    *   along with this program; if not, write to the                         *
+    *   Free Software Foundation, Inc.,                                       *
+    *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+    ***************************************************************************/
+#ifndef DUPLICATEFIELDSCOMMAND_H
+#define DUPLICATEFIELDSCOMMAND_H
+
+#include <QUndoCommand>
+#include <QList>
+#include <QSet>
+
+class Canvas;
+class Field;
+class FieldModel;
+class CSItem;
+/**
+ * @brief The DuplicateFieldsCommand class copies fields into a rows x columns grid.
+ * The selection is the top left cell, the copies get incremented ids.
+ */
+class DuplicateFieldsCommand : public QUndoCommand
+{
+public:
+  DuplicateFieldsCommand(Canvas* canvas, FieldModel* model, QList<Field*> sources, int rows, int columns,
+                         qreal hSpacing, qreal vSpacing, QUndoCommand* parent = 0);
+
+  void undo() override;
+  void redo() override;
+
+  static QString nextId(FieldModel* model, const QString& id, int step, QSet<QString>& used);
+
+private:
+  Canvas* m_canvas;
+  FieldModel* m_model;
+  QList<CSItem*> m_copies;
+};
+
+#endif // DUPLICATEFIELDSCOMMAND_H
@@ -19,8 +19,8 @@
     ***************************************************************************/
 #include "movefieldcommand.h"
 
-MoveFieldCommand::MoveFieldCommand(QList<QGraphicsItem*> list, QList<QPointF> oldPos, QUndoCommand* parent)
-    : QUndoCommand(parent),m_list(list),m_oldPoints(oldPos)
+MoveFieldCommand::MoveFieldCommand(QList<QGraphicsItem*> list, QList<QPointF> oldPos, bool nudge, QUndoCommand* parent)
+    : QUndoCommand(parent),m_list(list),m_oldPoints(oldPos),m_nudge(nudge)
 {
     if(m_list.size() == m_oldPoints.size())
     {
@@ -51,3 +51,37 @@ void MoveFieldCommand::redo()
         ++i;
     }
 }
+
+int MoveFieldCommand::id() const
+{
+    return 1;
+}
+
+bool MoveFieldCommand::mergeWith(const QUndoCommand* other)
+{
+    // arrow key nudges join the previous move of the same fields.
+    auto move = static_cast<const MoveFieldCommand*>(other);
+    if(!move->m_nudge || move->m_list.size() != m_list.size()
+       || move->m_newPoints.size() != move->m_list.size())
+        return false;
+
+    // selectedItems() has no stable order, the fields are matched as a set.
+    QHash<QGraphicsItem*,QPointF> newPoints;
+    for(int i = 0; i < move->m_list.size(); ++i)
+    {
+        newPoints.insert(move->m_list.at(i),move->m_newPoints.at(i));
+    }
+    if(newPoints.size() != m_list.size())
+        return false;
+    for(auto item : m_list)
+    {
+        if(!newPoints.contains(item))
+            return false;
+    }
+
+    for(int i = 0; i < m_list.size() && i < m_newPoints.size(); ++i)
+    {
+        m_newPoints[i] = newPoints.value(m_list.at(i));
+    }
+    return true;
+}
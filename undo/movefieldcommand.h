@@ -22,20 +22,25 @@
 
 #include <QUndoCommand>
 #include <QList>
+#include <QHash>
 #include <QGraphicsItem>
 
 class MoveFieldCommand : public QUndoCommand
 {
 public:
-  MoveFieldCommand(QList<QGraphicsItem*> list, QList<QPointF> oldPos, QUndoCommand* parent = 0);
+  MoveFieldCommand(QList<QGraphicsItem*> list, QList<QPointF> oldPos, bool nudge = false, QUndoCommand* parent = 0);
 
   void undo() override;
   void redo() override;
 
+  int id() const override;
+  bool mergeWith(const QUndoCommand* other) override;
+
 private:
   QList<QGraphicsItem*> m_list;
   QList<QPointF> m_oldPoints;
   QList<QPointF> m_newPoints;
+  bool m_nudge;
 
 };
 
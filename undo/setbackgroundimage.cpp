@@ -18,24 +18,31 @@
     *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
     ***************************************************************************/
 #include "setbackgroundimage.h"
+#include "tiledbackgrounditem.h"
+
+#include <QFile>
 
 SetBackgroundCommand::SetBackgroundCommand(Canvas* canvas,const QUrl& url,QUndoCommand *parent)
-  : QUndoCommand(parent),m_image(new QPixmap(url.toLocalFile())),m_canvas(canvas)
+  : QUndoCommand(parent),m_canvas(canvas)
 {
+    QFile file(url.toLocalFile());
+    if(file.open(QIODevice::ReadOnly))
+        m_data = file.readAll();
     init();
 }
-SetBackgroundCommand::SetBackgroundCommand(Canvas* canvas,QPixmap* pix, QUndoCommand *parent)
- : QUndoCommand(parent),m_image(pix),m_canvas(canvas)
+SetBackgroundCommand::SetBackgroundCommand(Canvas* canvas,const QByteArray& data,const QPixmap& decoded, QUndoCommand *parent)
+ : QUndoCommand(parent),m_data(data),m_decoded(decoded),m_canvas(canvas)
 {
    init();
 }
 void SetBackgroundCommand::init()
 {
     m_previousRect = m_canvas->sceneRect();
+    m_previousData = m_canvas->backgroundData();
     m_bgItem = m_canvas->getBg();
     if(nullptr == m_bgItem)
     {
-        m_bgItem = new QGraphicsPixmapItem();
+        m_bgItem = new TiledBackgroundItem();
         m_bgItem->setFlag(QGraphicsItem::ItemIsSelectable,false);
         m_bgItem->setFlag(QGraphicsItem::ItemSendsGeometryChanges,false);
         m_bgItem->setFlag(QGraphicsItem::ItemIsMovable,false);
@@ -48,21 +55,27 @@ void SetBackgroundCommand::init()
 
 void SetBackgroundCommand::undo()
 {
-    if(nullptr != m_bgItem)
+    if(nullptr == m_bgItem)
+        return;
+    if(m_previousData.isEmpty())
     {
-        QPixmap map;
-        m_bgItem->setPixmap(map);
-        m_canvas->setPixmap(nullptr);
+        m_canvas->clearBackground();
         m_canvas->removeItem(m_bgItem);
-        m_canvas->setSceneRect(m_previousRect);
     }
+    else
+    {
+        m_canvas->setBackground(m_previousData);
+    }
+    m_canvas->setSceneRect(m_previousRect);
 }
 
 void SetBackgroundCommand::redo()
 {
-   m_bgItem->setPixmap(*m_image);
-   m_canvas->addItem(m_bgItem);
+   // the decoded image is handed over once, the canvas decodes the bytes again when needed.
+   m_canvas->setBackground(m_data,m_decoded);
+   m_decoded = QPixmap();
+   if(m_bgItem->scene() != m_canvas)
+       m_canvas->addItem(m_bgItem);
    m_bgItem->setZValue(-1);
-   m_canvas->setPixmap(m_image);
-   m_canvas->setSceneRect(m_bgItem->boundingRect());
+   m_canvas->setSceneRect(QRectF(QPointF(0,0),m_canvas->backgroundSize()));
 }
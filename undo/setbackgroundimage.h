@@ -30,7 +30,7 @@ class SetBackgroundCommand : public QUndoCommand
 {
 public:
   SetBackgroundCommand(Canvas* canvas,const QUrl& url, QUndoCommand *parent = nullptr);
-  SetBackgroundCommand(Canvas* canvas,QPixmap* pix, QUndoCommand *parent = nullptr);
+  SetBackgroundCommand(Canvas* canvas,const QByteArray& data,const QPixmap& decoded = QPixmap(), QUndoCommand *parent = nullptr);
 
 
   void undo() override;
@@ -39,7 +39,9 @@ public:
 protected:
   void init();
 private:
-   QPixmap* m_image;
+   QByteArray m_data;
+   QPixmap m_decoded;
+   QByteArray m_previousData;
    Canvas* m_canvas;
    QGraphicsPixmapItem* m_bgItem;
    QRectF m_previousRect;
@@ -30,17 +30,23 @@ SetFieldPropertyCommand::SetFieldPropertyCommand(FieldModel* model,QList<Charact
 }
 void SetFieldPropertyCommand::undo()
 {
+    m_model->beginTransaction();
     int i = 0;
     for(auto index : m_selection)
     {
         index->setValueFrom(static_cast<CharacterSheetItem::ColumnId>(m_col),m_oldValues.at(i));
         ++i;
     }
+    m_model->propagateEdit(m_selection,static_cast<CharacterSheetItem::ColumnId>(m_col));
+    m_model->commitTransaction();
 }
 void SetFieldPropertyCommand::redo()
 {
+    m_model->beginTransaction();
     for(auto index : m_selection)
     {
         index->setValueFrom(static_cast<CharacterSheetItem::ColumnId>(m_col),m_newValue);
     }
+    m_model->propagateEdit(m_selection,static_cast<CharacterSheetItem::ColumnId>(m_col));
+    m_model->commitTransaction();
 }
@@ -0,0 +1,69 @@
+/***************************************************************************
+    *	 Copyright (C) 2019 by Renaud Guezennec                                *
+    *   http://www.rolisteam.org/contact                   *
+    *                                                                         *
+    *   This program is free software; you can redistribute it and/or modify  *
+    *   it under the terms of the GNU General Public License as published by  *
+    *   the Free Software Foundation; either version 2 of the License, or     *
+    *   (at your option) any later version.                                   *
+    *                                                                         *
+    *   This program is distributed in the hope that it will be useful,       *
+    *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+    *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+    *   GNU General Public License for more details.                          *
+    *                                                                         *
+    *   You should have received a copy of the GNU General Public License     *
+    *   along with this program; if not, write to the                         *
+    *   Free Software Foundation, Inc.,                                       *
+    *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+    ***************************************************************************/
+#include "setgeometrycommand.h"
+
+#include "canvasfield.h"
+#include "fieldmodel.h"
+
+SetGeometryCommand::SetGeometryCommand(FieldModel* model, QList<CanvasField*> fields, QList<QRectF> geometries, const QString& text, QUndoCommand* parent)
+  : QUndoCommand(parent),m_model(model),m_fields(fields),m_newGeometries(geometries)
+{
+    for(auto field : m_fields)
+    {
+        m_oldGeometries.append(geometry(field));
+    }
+    setText(text);
+}
+
+QRectF SetGeometryCommand::geometry(CanvasField* field)
+{
+    return QRectF(field->pos(),field->boundingRect().size());
+}
+
+void SetGeometryCommand::undo()
+{
+    apply(m_oldGeometries);
+}
+
+void SetGeometryCommand::redo()
+{
+    apply(m_newGeometries);
+}
+
+void SetGeometryCommand::apply(const QList<QRectF>& geometries)
+{
+    if(geometries.size() != m_fields.size())
+        return;
+
+    // the model sends its updates once every field is in place
+    if(nullptr != m_model)
+        m_model->beginTransaction();
+    int i = 0;
+    for(auto field : m_fields)
+    {
+        const QRectF& rect = geometries.at(i);
+        field->setPos(rect.topLeft());
+        field->setWidth(rect.width());
+        field->setHeight(rect.height());
+        ++i;
+    }
+    if(nullptr != m_model)
+        m_model->commitTransaction();
+}
@@ -0,0 +1,53 @@
+/***************************************************************************
+    *	 Copyright (C) 2019 by Renaud Guezennec                                *
+    *   http://www.rolisteam.org/contact                   *
+    *                                                                         *
+    *   This program is free software; you can redistribute it and/or modify  *
+    *   it under the terms of the GNU General Public License as published by  *
+    *   the Free Software Foundation; either version 2 of the License, or     *
+    *   (at your option) any later version.                                   *
+    *                                                                         *
+    *   This program is distributed in the hope that it will be useful,       *
+    *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+    *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+    *   GNU General Public License for more details.                          *
+    *                                                                         *
+    *   You should have received a copy of the GNU General Public License     *
+    *   along with this program; if not, write to the                         *
+    *   Free Software Foundation, Inc.,                                       *
+    *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+    ***************************************************************************/
+#ifndef SETGEOMETRYCOMMAND_H
+#define SETGEOMETRYCOMMAND_H
+
+#include <QUndoCommand>
+#include <QList>
+#include <QRectF>
+
+class CanvasField;
+class FieldModel;
+/**
+ * @brief The SetGeometryCommand class moves and resizes several fields as one step.
+ * Geometries are rects in the parent coordinates: top left is the position, size the field size.
+ */
+class SetGeometryCommand : public QUndoCommand
+{
+public:
+  SetGeometryCommand(FieldModel* model, QList<CanvasField*> fields, QList<QRectF> geometries, const QString& text, QUndoCommand* parent = 0);
+
+  void undo() override;
+  void redo() override;
+
+  static QRectF geometry(CanvasField* field);
+
+private:
+  void apply(const QList<QRectF>& geometries);
+
+private:
+  FieldModel* m_model;
+  QList<CanvasField*> m_fields;
+  QList<QRectF> m_oldGeometries;
+  QList<QRectF> m_newGeometries;
+};
+
+#endif // SETGEOMETRYCOMMAND_H
@@ -2,6 +2,9 @@
 
 #include <QMenu>
 #include <QColorDialog>
+#include <algorithm>
+
+#include "fieldmodel.h"
 
 //commands
 #include "undo/deletefieldcommand.h"
@@ -193,6 +196,57 @@ void FieldView::setFieldModel(FieldModel *model)
 {
     m_model = model;
     setModel(m_model);
+    connect(selectionModel(),&QItemSelectionModel::selectionChanged,this,&FieldView::sendSelectedFields);
+}
+
+void FieldView::selectFields(const QList<Field*>& fields)
+{
+    if(nullptr == m_model)
+        return;
+
+    QList<int> rows;
+    for(auto field : fields)
+    {
+        auto index = m_model->indexOf(field);
+        if(index.isValid())
+            rows.append(index.row());
+    }
+    std::sort(rows.begin(),rows.end());
+
+    // one range per block of consecutive rows, applied in a single select() call.
+    QItemSelection selection;
+    int lastColumn = m_model->columnCount()-1;
+    for(int i = 0; i < rows.size(); )
+    {
+        int j = i;
+        while(j+1 < rows.size() && rows[j+1] == rows[j]+1)
+            ++j;
+        selection.select(m_model->index(rows[i],0),m_model->index(rows[j],lastColumn));
+        i = j+1;
+    }
+
+    m_syncingSelection = true;
+    selectionModel()->select(selection,QItemSelectionModel::ClearAndSelect);
+    m_syncingSelection = false;
+    if(!rows.isEmpty())
+        scrollTo(m_model->index(rows.first(),0));
+}
+
+void FieldView::sendSelectedFields()
+{
+    if(m_syncingSelection)
+        return;
+
+    QList<Field*> fields;
+    for(const auto& index : selectionModel()->selectedIndexes())
+    {
+        if(index.column() != 0)
+            continue;
+        auto field = m_model->getFieldFromIndex(index);
+        if(nullptr != field)
+            fields.append(field);
+    }
+    emit fieldsSelected(fields);
 }
 
 QList<Canvas *> *FieldView::getCanvasList() const
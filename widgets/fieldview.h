@@ -9,6 +9,7 @@
 class QUndoStack;
 class FieldModel;
 class Canvas;
+class Field;
 class FieldView : public QTreeView
 {
     Q_OBJECT
@@ -32,10 +33,18 @@ public:
 
 
 
+    void selectFields(const QList<Field*>& fields);
+
+signals:
+    void fieldsSelected(const QList<Field*>& fields);
+
 public slots:
     void editColor(QModelIndex index);
     void hideAllColumns(bool);
 
+private slots:
+    void sendSelectedFields();
+
 protected:
     void contextMenuEvent(QContextMenuEvent* event) override;
 private:
@@ -58,6 +67,7 @@ private:
     int* m_currentPage= nullptr;
 
     QSignalMapper* m_mapper = nullptr;
+    bool m_syncingSelection = false;
 };
 
 #endif // FIELDVIEW_H
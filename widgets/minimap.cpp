@@ -0,0 +1,171 @@
+#include "minimap.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+MiniMap::MiniMap(QWidget* parent)
+    : QWidget(parent)
+{
+    // scene changes come once per frame while dragging, the minimap is redrawn at a slower pace.
+    m_renderTimer.setSingleShot(true);
+    m_renderTimer.setInterval(100);
+    connect(&m_renderTimer,&QTimer::timeout,this,&MiniMap::renderDirty);
+    setMinimumSize(120,120);
+}
+
+QSize MiniMap::sizeHint() const
+{
+    return QSize(200,260);
+}
+
+void MiniMap::setView(QGraphicsView* view)
+{
+    if(!m_view.isNull())
+    {
+        disconnect(m_view->horizontalScrollBar(),nullptr,this,nullptr);
+        disconnect(m_view->verticalScrollBar(),nullptr,this,nullptr);
+    }
+    m_view = view;
+    if(!m_view.isNull())
+    {
+        // scrolling and zooming only move the viewport rectangle, the cache stays valid.
+        connect(m_view->horizontalScrollBar(),&QScrollBar::valueChanged,this,[this](){ update(); });
+        connect(m_view->verticalScrollBar(),&QScrollBar::valueChanged,this,[this](){ update(); });
+        connect(m_view->horizontalScrollBar(),&QScrollBar::rangeChanged,this,[this](){ update(); });
+        connect(m_view->verticalScrollBar(),&QScrollBar::rangeChanged,this,[this](){ update(); });
+        setScene(m_view->scene());
+    }
+}
+
+void MiniMap::setScene(QGraphicsScene* scene)
+{
+    if(m_scene == scene)
+        return;
+    if(!m_scene.isNull())
+        disconnect(m_scene,nullptr,this,nullptr);
+    m_scene = scene;
+    if(!m_scene.isNull())
+    {
+        connect(m_scene,&QGraphicsScene::changed,this,&MiniMap::sceneChanged);
+        connect(m_scene,&QGraphicsScene::sceneRectChanged,this,&MiniMap::invalidateAll);
+    }
+    invalidateAll();
+}
+
+void MiniMap::sceneChanged(const QList<QRectF>& region)
+{
+    if(m_fullRender)
+        return;
+    m_dirty.append(region);
+    m_renderTimer.start();
+}
+
+void MiniMap::invalidateAll()
+{
+    m_fullRender = true;
+    m_dirty.clear();
+    m_renderTimer.start();
+}
+
+QRectF MiniMap::targetRect() const
+{
+    if(m_sceneRect.isEmpty())
+        return QRectF();
+    QSizeF fitted = m_sceneRect.size().scaled(QSizeF(size()),Qt::KeepAspectRatio);
+    return QRectF(QPointF((width()-fitted.width())/2,(height()-fitted.height())/2),fitted);
+}
+
+void MiniMap::renderDirty()
+{
+    if(m_scene.isNull())
+    {
+        m_cache = QImage();
+        update();
+        return;
+    }
+
+    QRectF sceneRect = m_scene->sceneRect();
+    if(m_fullRender || sceneRect != m_sceneRect)
+    {
+        m_sceneRect = sceneRect;
+        QSize size = targetRect().size().toSize();
+        if(size.isEmpty())
+            return;
+        m_cache = QImage(size,QImage::Format_ARGB32_Premultiplied);
+        m_cache.fill(Qt::white);
+        m_dirty = QList<QRectF>() << m_sceneRect;
+        m_fullRender = false;
+    }
+
+    qreal scale = m_cache.width()/m_sceneRect.width();
+    QPainter painter(&m_cache);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for(const auto& rect : m_dirty)
+    {
+        QRectF source = rect.intersected(m_sceneRect);
+        if(source.isEmpty())
+            continue;
+        // aligned on cache pixels, so neighbouring regions do not leave seams.
+        QRectF target((source.left()-m_sceneRect.left())*scale,(source.top()-m_sceneRect.top())*scale,
+                      source.width()*scale,source.height()*scale);
+        QRect pixels = target.toAlignedRect();
+        source = QRectF(m_sceneRect.left()+pixels.left()/scale,m_sceneRect.top()+pixels.top()/scale,
+                        pixels.width()/scale,pixels.height()/scale);
+        painter.fillRect(pixels,Qt::white);
+        m_scene->render(&painter,QRectF(pixels),source,Qt::IgnoreAspectRatio);
+    }
+    painter.end();
+    m_dirty.clear();
+    update();
+}
+
+void MiniMap::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(),palette().window());
+    if(m_cache.isNull())
+        return;
+
+    QRectF target = targetRect();
+    painter.drawImage(target.topLeft(),m_cache);
+
+    if(m_view.isNull())
+        return;
+    QRectF visible = m_view->mapToScene(m_view->viewport()->rect()).boundingRect();
+    qreal scale = target.width()/m_sceneRect.width();
+    QRectF viewport((visible.left()-m_sceneRect.left())*scale+target.left(),
+                    (visible.top()-m_sceneRect.top())*scale+target.top(),
+                    visible.width()*scale,visible.height()*scale);
+    painter.setPen(QPen(Qt::red,2));
+    painter.drawRect(viewport.intersected(target));
+}
+
+void MiniMap::resizeEvent(QResizeEvent* event)
+{
+    QWidget::resizeEvent(event);
+    invalidateAll();
+}
+
+void MiniMap::centerViewOn(const QPoint& pos)
+{
+    QRectF target = targetRect();
+    if(m_view.isNull() || target.isEmpty())
+        return;
+    qreal scale = m_sceneRect.width()/target.width();
+    m_view->centerOn(QPointF((pos.x()-target.left())*scale+m_sceneRect.left(),
+                             (pos.y()-target.top())*scale+m_sceneRect.top()));
+}
+
+void MiniMap::mousePressEvent(QMouseEvent* event)
+{
+    if(event->button() == Qt::LeftButton)
+        centerViewOn(event->pos());
+}
+
+void MiniMap::mouseMoveEvent(QMouseEvent* event)
+{
+    if(event->buttons() & Qt::LeftButton)
+        centerViewOn(event->pos());
+}
@@ -0,0 +1,52 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <QWidget>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QImage>
+#include <QPointer>
+#include <QTimer>
+
+/**
+ * @brief The MiniMap class shows a downsampled render of the edited page with the visible area.
+ * The render is cached, only the regions reported by QGraphicsScene::changed() are drawn again.
+ * Clicking or dragging on it centres the view on that point.
+ */
+class MiniMap : public QWidget
+{
+    Q_OBJECT
+public:
+    MiniMap(QWidget* parent = nullptr);
+
+    void setView(QGraphicsView* view);
+    void setScene(QGraphicsScene* scene);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+
+private slots:
+    void sceneChanged(const QList<QRectF>& region);
+    void invalidateAll();
+    void renderDirty();
+
+private:
+    QRectF targetRect() const;
+    void centerViewOn(const QPoint& pos);
+
+private:
+    QPointer<QGraphicsView> m_view;
+    QPointer<QGraphicsScene> m_scene;
+    QImage m_cache;
+    QRectF m_sceneRect;
+    QList<QRectF> m_dirty;
+    bool m_fullRender = true;
+    QTimer m_renderTimer;
+};
+
+#endif // MINIMAP_H
@@ -0,0 +1,190 @@
+#include "pagestrip.h"
+
+#include <QBuffer>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QPainter>
+#include <QtConcurrent>
+
+#include "canvas.h"
+#include "fieldmodel.h"
+#include "imagemodel.h"
+#include "imagestore.h"
+
+#define THUMBNAIL_WIDTH 120
+#define THUMBNAIL_HEIGHT 170
+
+PageStrip::PageStrip(QWidget* parent)
+    : QListWidget(parent)
+{
+    setViewMode(QListView::IconMode);
+    setFlow(QListView::TopToBottom);
+    setWrapping(false);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setIconSize(QSize(THUMBNAIL_WIDTH,THUMBNAIL_HEIGHT));
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    // edits come in bursts (drags, undo...), the strip follows them at a slower pace.
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(300);
+    connect(&m_refreshTimer,&QTimer::timeout,this,&PageStrip::refresh);
+    connect(this,&QListWidget::currentRowChanged,this,[this](int row){
+        if(row >= 0)
+            emit pageSelected(row);
+    });
+}
+
+void PageStrip::setCanvasList(QList<Canvas*>* canvasList)
+{
+    m_canvasList = canvasList;
+    scheduleRefresh();
+}
+
+void PageStrip::setFieldModel(FieldModel* model)
+{
+    m_model = model;
+    scheduleRefresh();
+}
+
+void PageStrip::setImageModel(ImageModel* model)
+{
+    m_imageModel = model;
+    scheduleRefresh();
+}
+
+void PageStrip::setCurrentPage(int page)
+{
+    if(page == currentRow())
+        return;
+    QSignalBlocker blocker(this);
+    setCurrentRow(page);
+}
+
+void PageStrip::scheduleRefresh()
+{
+    m_refreshTimer.start();
+}
+
+PageStrip::Snapshot PageStrip::snapshot(int page, qint64& signature) const
+{
+    Snapshot snap;
+    Canvas* canvas = m_canvasList->at(page);
+    snap.m_size = canvas->sceneRect().size().toSize();
+
+    // every background is kept encoded by its canvas, the bytes identify it
+    snap.m_data = canvas->backgroundData();
+    qint64 backgroundKey = reinterpret_cast<qint64>(snap.m_data.constData());
+    if(nullptr != m_imageModel && !canvas->backgroundKey().isEmpty())
+    {
+        auto store = m_imageModel->store();
+        if(store->imageData(canvas->backgroundKey()).m_data.constData() == snap.m_data.constData())
+        {
+            snap.m_store = store;
+            snap.m_key = canvas->backgroundKey();
+        }
+    }
+
+    uint hash = qHash(backgroundKey);
+    hash = qHash(snap.m_size.width(),hash) ^ qHash(snap.m_size.height(),hash);
+    if(nullptr != m_model)
+    {
+        QList<CharacterSheetItem*> list;
+        m_model->getFieldFromPage(page,list);
+        for(auto item : list)
+        {
+            auto field = dynamic_cast<Field*>(item);
+            if(nullptr == field)
+                continue;
+            QRectF rect(item->getValueFrom(CharacterSheetItem::X,Qt::DisplayRole).toReal(),
+                        item->getValueFrom(CharacterSheetItem::Y,Qt::DisplayRole).toReal(),
+                        item->getValueFrom(CharacterSheetItem::WIDTH,Qt::DisplayRole).toReal(),
+                        item->getValueFrom(CharacterSheetItem::HEIGHT,Qt::DisplayRole).toReal());
+            snap.m_rects.append(rect);
+            snap.m_colors.append(field->bgColor());
+            hash = qHash(rect.x(),hash) + qHash(rect.y(),hash)*3 + qHash(rect.width(),hash)*5
+                    + qHash(rect.height(),hash)*7 + field->bgColor().rgba()*11 + hash*31;
+        }
+    }
+    signature = hash;
+    return snap;
+}
+
+QImage PageStrip::render(const Snapshot& snap)
+{
+    QSize size = snap.m_size;
+    QImage background;
+    if(!snap.m_store.isNull())
+    {
+        // the store keeps the reduced level, the next render of this page does not decode again
+        size = snap.m_store->size(snap.m_key);
+        background = snap.m_store->image(snap.m_key,size.scaled(THUMBNAIL_WIDTH,THUMBNAIL_HEIGHT,Qt::KeepAspectRatio));
+    }
+    else if(!snap.m_data.isEmpty())
+    {
+        QBuffer buffer;
+        buffer.setData(snap.m_data);
+        QImageReader reader(&buffer);
+        if(reader.size().isValid())
+        {
+            size = reader.size();
+            reader.setScaledSize(size.scaled(THUMBNAIL_WIDTH,THUMBNAIL_HEIGHT,Qt::KeepAspectRatio));
+        }
+        background = reader.read();
+    }
+    if(size.isEmpty())
+        size = QSize(THUMBNAIL_WIDTH,THUMBNAIL_HEIGHT);
+
+    QImage thumb(size.scaled(THUMBNAIL_WIDTH,THUMBNAIL_HEIGHT,Qt::KeepAspectRatio),QImage::Format_ARGB32_Premultiplied);
+    thumb.fill(Qt::white);
+    QPainter painter(&thumb);
+    if(!background.isNull())
+        painter.drawImage(thumb.rect(),background);
+
+    qreal scale = static_cast<qreal>(thumb.width())/size.width();
+    painter.scale(scale,scale);
+    painter.setPen(QPen(Qt::black,0));
+    for(int i = 0; i < snap.m_rects.size(); ++i)
+    {
+        QColor color = snap.m_colors.at(i);
+        painter.fillRect(snap.m_rects.at(i),color);
+        painter.drawRect(snap.m_rects.at(i));
+    }
+    painter.end();
+    return thumb;
+}
+
+void PageStrip::refresh()
+{
+    if(nullptr == m_canvasList)
+        return;
+
+    int pages = m_canvasList->size();
+    while(count() > pages)
+    {
+        delete takeItem(count()-1);
+        m_signatures.remove(count());
+    }
+    while(count() < pages)
+    {
+        addItem(new QListWidgetItem(tr("Page %1").arg(count()+1)));
+    }
+
+    for(int page = 0; page < pages; ++page)
+    {
+        qint64 signature = 0;
+        Snapshot snap = snapshot(page,signature);
+        if(m_signatures.contains(page) && m_signatures.value(page) == signature)
+            continue;
+        m_signatures.insert(page,signature);
+
+        auto watcher = new QFutureWatcher<QImage>(this);
+        connect(watcher,&QFutureWatcher<QImage>::finished,this,[this,watcher,page,signature](){
+            // a newer render may have been started meanwhile
+            if(page < count() && m_signatures.value(page) == signature)
+                item(page)->setIcon(QIcon(QPixmap::fromImage(watcher->result())));
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&PageStrip::render,snap));
+    }
+}
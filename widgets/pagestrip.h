@@ -0,0 +1,60 @@
+#ifndef PAGESTRIP_H
+#define PAGESTRIP_H
+
+#include <QListWidget>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QTimer>
+
+class Canvas;
+class FieldModel;
+class ImageModel;
+class ImageStore;
+/**
+ * @brief The PageStrip class shows one thumbnail per page: the background and the field rectangles.
+ * Thumbnails are rendered on a worker thread and only for pages whose content changed since the last render.
+ */
+class PageStrip : public QListWidget
+{
+    Q_OBJECT
+public:
+    PageStrip(QWidget* parent = nullptr);
+
+    void setCanvasList(QList<Canvas*>* canvasList);
+    void setFieldModel(FieldModel* model);
+    void setImageModel(ImageModel* model);
+
+signals:
+    void pageSelected(int page);
+
+public slots:
+    void setCurrentPage(int page);
+    void scheduleRefresh();
+
+private slots:
+    void refresh();
+
+private:
+    struct Snapshot
+    {
+        QByteArray m_data;
+        QSharedPointer<ImageStore> m_store; // set when the store holds m_data under m_key
+        QString m_key;
+        QSize m_size;
+        QVector<QRectF> m_rects;
+        QVector<QColor> m_colors;
+    };
+    Snapshot snapshot(int page, qint64& signature) const;
+    static QImage render(const Snapshot& snapshot);
+
+private:
+    QList<Canvas*>* m_canvasList = nullptr;
+    FieldModel* m_model = nullptr;
+    ImageModel* m_imageModel = nullptr;
+    QHash<int,qint64> m_signatures;
+    QTimer m_refreshTimer;
+};
+
+#endif // PAGESTRIP_H